@@ -10,40 +10,40 @@ using namespace std;
 
 namespace IR {
 
-unsigned num_locals_src;
-unsigned num_locals_tgt;
-unsigned num_consts_src;
-unsigned num_globals_src;
-unsigned num_ptrinputs;
-unsigned num_inaccessiblememonly_fns;
-unsigned num_nonlocals;
-unsigned num_nonlocals_src;
-unsigned bits_poison_per_byte;
-unsigned bits_for_ptrattrs;
-unsigned bits_for_bid;
-unsigned bits_for_offset;
-unsigned bits_program_pointer;
-unsigned bits_size_t;
-unsigned bits_ptr_address;
-unsigned bits_byte;
-unsigned strlen_unroll_cnt;
-unsigned memcmp_unroll_cnt;
-bool little_endian;
-bool observes_addresses;
-bool has_malloc;
-bool has_free;
-bool has_alloca;
-bool has_fncall;
-bool has_write_fncall;
-bool has_nocapture;
-bool has_noread;
-bool has_nowrite;
-bool has_dead_allocas;
-bool has_null_block;
-bool does_int_mem_access;
-bool does_ptr_mem_access;
-bool does_ptr_store;
-unsigned heap_block_alignment;
+thread_local unsigned num_locals_src;
+thread_local unsigned num_locals_tgt;
+thread_local unsigned num_consts_src;
+thread_local unsigned num_globals_src;
+thread_local unsigned num_ptrinputs;
+thread_local unsigned num_inaccessiblememonly_fns;
+thread_local unsigned num_nonlocals;
+thread_local unsigned num_nonlocals_src;
+thread_local unsigned bits_poison_per_byte;
+thread_local unsigned bits_for_ptrattrs;
+thread_local unsigned bits_for_bid;
+thread_local unsigned bits_for_offset;
+thread_local unsigned bits_program_pointer;
+thread_local unsigned bits_size_t;
+thread_local unsigned bits_ptr_address;
+thread_local unsigned bits_byte;
+thread_local unsigned strlen_unroll_cnt;
+thread_local unsigned memcmp_unroll_cnt;
+thread_local bool little_endian;
+thread_local bool observes_addresses;
+thread_local bool has_malloc;
+thread_local bool has_free;
+thread_local bool has_alloca;
+thread_local bool has_fncall;
+thread_local bool has_write_fncall;
+thread_local bool has_nocapture;
+thread_local bool has_noread;
+thread_local bool has_nowrite;
+thread_local bool has_dead_allocas;
+thread_local bool has_null_block;
+thread_local bool does_int_mem_access;
+thread_local bool does_ptr_mem_access;
+thread_local bool does_ptr_store;
+thread_local unsigned heap_block_alignment;
 
 
 bool isUndef(const expr &e) {
@@ -98,9 +98,9 @@ static bool always_nowrite(unsigned bid) {
 }
 
 
-static unsigned next_local_bid;
-static unsigned next_global_bid;
-static unsigned next_ptr_input;
+static thread_local unsigned next_local_bid;
+static thread_local unsigned next_global_bid;
+static thread_local unsigned next_ptr_input;
 
 static bool byte_has_ptr_bit() {
   return does_int_mem_access && does_ptr_mem_access;
@@ -613,8 +613,8 @@ void Memory::AliasSet::unionWith(const AliasSet &other) {
 }
 
 static const array<uint64_t, 5> alias_buckets_vals = { 1, 2, 3, 5, 10 };
-static array<uint64_t, 6> alias_buckets_hits = { 0 };
-static uint64_t only_local = 0, only_nonlocal = 0;
+static thread_local array<uint64_t, 6> alias_buckets_hits = { 0 };
+static thread_local uint64_t only_local = 0, only_nonlocal = 0;
 
 void Memory::AliasSet::computeAccessStats() const {
   auto nlocal = numMayAlias(true);
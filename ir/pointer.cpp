@@ -12,7 +12,7 @@ using namespace smt;
 using namespace std;
 using namespace util;
 
-static unsigned ptr_next_idx;
+static thread_local unsigned ptr_next_idx;
 
 static expr prepend_if(const expr &pre, expr &&e, bool prepend) {
   return prepend ? pre.concat(e) : std::move(e);
@@ -13,11 +13,20 @@ config::disable_poison_input = opt_disable_poison;
 config::symexec_print_each_value = opt_se_verbose;
 smt::set_query_timeout(to_string(opt_smt_to));
 smt::set_memory_limit((uint64_t)opt_smt_max_mem * 1024 * 1024);
+smt::solver_memory_governor(opt_smt_max_mem.getNumOccurrences() > 0);
 smt::set_random_seed(to_string(opt_smt_random_seed));
 config::skip_smt = opt_smt_skip;
 config::smt_benchmark_dir = opt_smt_bench_dir;
+config::smt_telemetry_file = opt_smt_telemetry;
+config::smt_retry_dir = opt_smt_retry_dir;
+config::smt_cache_dir = opt_smt_cache_dir;
+config::smt_cache_max_size = (uint64_t)opt_smt_cache_size * 1024 * 1024;
 smt::solver_print_queries(opt_smt_verbose);
 smt::solver_tactic_verbose(opt_tactic_verbose);
+smt::solver_portfolio(opt_smt_portfolio);
+smt::solver_select_tactics(opt_smt_select_tactics);
+smt::expr_count_folds(opt_fold_stats);
+config::parallel_checks = opt_parallel_checks;
 config::debug = opt_debug;
 config::max_offset_bits = opt_max_offset_in_bits;
 
@@ -54,7 +54,8 @@ llvm::cl::opt<unsigned> opt_smt_to(LLVM_ARGS_PREFIX "smt-to",
   llvm::cl::cat(alive_cmdargs));
 
 llvm::cl::opt<unsigned> opt_smt_max_mem(LLVM_ARGS_PREFIX "smt-max-mem",
-  llvm::cl::desc("AMT max memory (approx)"), llvm::cl::value_desc("MB"),
+  llvm::cl::desc("SMT max memory (approx). If given, checks that use more "
+                 "are interrupted"), llvm::cl::value_desc("MB"),
   llvm::cl::init(1024), llvm::cl::cat(alive_cmdargs));
 
 llvm::cl::opt<bool> opt_smt_stats(LLVM_ARGS_PREFIX "smt-stats",
@@ -74,9 +75,50 @@ llvm::cl::opt<bool> opt_smt_skip(LLVM_ARGS_PREFIX "skip-smt",
   llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
 
 llvm::cl::opt<string> opt_smt_bench_dir(LLVM_ARGS_PREFIX "smt-bench",
-  llvm::cl::desc("Dump smtlib benchmarks"),
+  llvm::cl::desc("Dump smtlib benchmarks into an archive of distinct queries "
+                 "(read with scripts/smt-bench.py)"),
   llvm::cl::value_desc("directory"), llvm::cl::cat(alive_cmdargs));
 
+llvm::cl::opt<string> opt_smt_telemetry(LLVM_ARGS_PREFIX "smt-telemetry",
+  llvm::cl::desc("Append a JSON line describing each SMT query to this file"),
+  llvm::cl::value_desc("filename"), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<string> opt_smt_retry_dir(LLVM_ARGS_PREFIX "smt-retry-dir",
+  llvm::cl::desc("Queue the SMT queries that time out in this directory, to "
+                 "retry them with alive-smt-retry or --smt-retry-to"),
+  llvm::cl::value_desc("directory"), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<unsigned> opt_smt_retry_to(LLVM_ARGS_PREFIX "smt-retry-to",
+  llvm::cl::desc("Retry the queued SMT queries at the end of the run with "
+                 "timeouts up to this many ms (default=0: don't retry)"),
+  llvm::cl::init(0), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<string> opt_smt_cache_dir(LLVM_ARGS_PREFIX "smt-cache",
+  llvm::cl::desc("Cache UNSAT and timeout results of SMT queries in this "
+                 "directory, which may be shared by concurrent runs"),
+  llvm::cl::value_desc("directory"), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<unsigned> opt_smt_cache_size(LLVM_ARGS_PREFIX "smt-cache-size",
+  llvm::cl::desc("Maximum size of the SMT query cache (default=1024)"),
+  llvm::cl::value_desc("MB"), llvm::cl::init(1024),
+  llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<unsigned> opt_smt_portfolio(LLVM_ARGS_PREFIX "smt-portfolio",
+  llvm::cl::desc("Race each SMT query against other solver configurations "
+                 "in this many processes in total (default=1: no portfolio)"),
+  llvm::cl::init(1), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<bool> opt_parallel_checks(LLVM_ARGS_PREFIX "parallel-checks",
+  llvm::cl::desc("Solve the refinement checks of each transformation "
+                 "concurrently in forked processes (default=false)"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
+llvm::cl::opt<bool> opt_smt_select_tactics(
+  LLVM_ARGS_PREFIX "smt-select-tactics",
+  llvm::cl::desc("Pick a cheaper tactic pipeline for quantifier-free SMT "
+                 "queries based on the theories they use (default=false)"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
 llvm::cl::opt<bool> opt_smt_verbose(LLVM_ARGS_PREFIX "smt-verbose",
   llvm::cl::desc("SMT verbose mode"),
   llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
@@ -107,6 +149,10 @@ llvm::cl::opt<bool> opt_alias_stats(LLVM_ARGS_PREFIX "alias-stats",
   llvm::cl::desc("Show alias sets statistics"),
   llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
 
+llvm::cl::opt<bool> opt_fold_stats(LLVM_ARGS_PREFIX "fold-stats",
+  llvm::cl::desc("Show the constant folds left to Z3, by operation"),
+  llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+
 #ifdef ARGS_REFINEMENT
 llvm::cl::opt<bool> opt_bidirectional(LLVM_ARGS_PREFIX "bidirectional",
   llvm::cl::desc("Run refinement check in both directions"),
@@ -59,9 +59,9 @@ bool has_constant_expr(llvm::Value *val) {
   return isa<llvm::ConstantExpr, llvm::ConstantAggregate>(val);
 }
 
-unsigned constexpr_idx;
-unsigned copy_idx;
-unsigned alignopbundle_idx;
+thread_local unsigned constexpr_idx;
+thread_local unsigned copy_idx;
+thread_local unsigned alignopbundle_idx;
 
 #if 0
 string_view s(llvm::StringRef str) {
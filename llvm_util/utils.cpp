@@ -23,27 +23,27 @@ using llvm::cast, llvm::dyn_cast, llvm::isa;
 namespace {
 
 // cache Value*'s names
-unordered_map<const llvm::Value*, string> value_names;
-unsigned value_id_counter; // for %0, %1, etc..
+thread_local unordered_map<const llvm::Value*, string> value_names;
+thread_local unsigned value_id_counter; // for %0, %1, etc..
 
-vector<unique_ptr<IntType>> int_types;
-vector<unique_ptr<PtrType>> ptr_types;
-FloatType half_type("half", FloatType::Half);
-FloatType float_type("float", FloatType::Float);
-FloatType double_type("double", FloatType::Double);
-FloatType quad_type("fp128", FloatType::Quad);
-FloatType bfloat_type("bfloat", FloatType::BFloat);
+thread_local vector<unique_ptr<IntType>> int_types;
+thread_local vector<unique_ptr<PtrType>> ptr_types;
+thread_local FloatType half_type("half", FloatType::Half);
+thread_local FloatType float_type("float", FloatType::Float);
+thread_local FloatType double_type("double", FloatType::Double);
+thread_local FloatType quad_type("fp128", FloatType::Quad);
+thread_local FloatType bfloat_type("bfloat", FloatType::BFloat);
 
 // cache complex types
-unordered_map<const llvm::Type*, unique_ptr<Type>> type_cache;
-unsigned type_id_counter; // for unamed types
+thread_local unordered_map<const llvm::Type*, unique_ptr<Type>> type_cache;
+thread_local unsigned type_id_counter; // for unamed types
 
-Function *current_fn;
-unordered_map<const llvm::Value*, Value*> value_cache;
+thread_local Function *current_fn;
+thread_local unordered_map<const llvm::Value*, Value*> value_cache;
 
-ostream *out;
+thread_local ostream *out;
 
-const llvm::DataLayout *DL;
+thread_local const llvm::DataLayout *DL;
 
 bool hasOpaqueType(llvm::Type *ty) {
   if (auto aty = llvm::dyn_cast<llvm::StructType>(ty)) {
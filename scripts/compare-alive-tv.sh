@@ -0,0 +1,78 @@
+#!/bin/bash
+# Copyright (c) 2018-present The Alive2 Authors.
+# Distributed under the MIT license that can be found in the LICENSE file.
+
+# Runs two alive-tv binaries over the same tests and reports the time each
+# took, the tests with the largest differences, and the tests whose verdicts
+# differ.
+# Usage: compare-alive-tv.sh OLD-ALIVE-TV NEW-ALIVE-TV [TEST...]
+# Tests default to tests/alive-tv/*.srctgt.ll. Extra alive-tv options can be
+# given in $ALIVE_OPTS (default: --smt-to=10000). $REPEAT sets the runs per
+# test, of which the fastest is kept (default: 3), since a single slow query
+# can otherwise dominate the totals.
+
+if [ $# -lt 2 ]; then
+  echo "Usage: $0 OLD-ALIVE-TV NEW-ALIVE-TV [TEST...]" >&2
+  exit 1
+fi
+
+OLD=$1
+NEW=$2
+shift 2
+TESTS=("$@")
+if [ ${#TESTS[@]} -eq 0 ]; then
+  TESTS=($(dirname "$0")/../tests/alive-tv/*.srctgt.ll)
+fi
+ALIVE_OPTS=${ALIVE_OPTS:---smt-to=10000}
+REPEAT=${REPEAT:-3}
+
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+now_ms() {
+  echo $(( $(date +%s%N) / 1000000 ))
+}
+
+run() {
+  local bin=$1 test=$2 best=-1 start ms
+  for (( i = 0; i < REPEAT; ++i )); do
+    start=$(now_ms)
+    $bin $ALIVE_OPTS "$test" > "$OUT/run" 2>&1
+    ms=$(( $(now_ms) - start ))
+    if [ $best -lt 0 ] || [ $ms -lt $best ]; then
+      best=$ms
+    fi
+  done
+  grep -E -e "seems to be correct|doesn't verify|^ERROR|always false" \
+          -e "doesn't reach" "$OUT/run"
+  echo "time $best"
+}
+
+old_total=0
+new_total=0
+for test in "${TESTS[@]}"; do
+  name=$(basename "$test")
+  run "$OLD" "$test" > "$OUT/old"
+  run "$NEW" "$test" > "$OUT/new"
+  old_ms=$(sed -n 's/^time //p' "$OUT/old")
+  new_ms=$(sed -n 's/^time //p' "$OUT/new")
+  old_total=$(( old_total + old_ms ))
+  new_total=$(( new_total + new_ms ))
+  echo "$(( old_ms - new_ms )) $name $old_ms $new_ms" >> "$OUT/times"
+  if ! diff -q <(grep -v ^time "$OUT/old") <(grep -v ^time "$OUT/new") \
+         > /dev/null; then
+    echo "Verdict changed: $name"
+    grep -v ^time "$OUT/old" | sed 's/^/  old: /'
+    grep -v ^time "$OUT/new" | sed 's/^/  new: /'
+  fi
+done
+
+echo
+echo "Largest differences (ms):"
+awk '{ d = $1 < 0 ? -$1 : $1; print d, $0 }' "$OUT/times" |
+  sort -n -r | head -10 |
+  awk '{ printf "  %-45s old %7d  new %7d\n", $3, $4, $5 }'
+echo
+echo "Tests: ${#TESTS[@]}"
+echo "Old total: $old_total ms"
+echo "New total: $new_total ms"
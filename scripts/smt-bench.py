@@ -0,0 +1,81 @@
+#!/usr/bin/python3
+
+# Reads the benchmark archives written by alive-tv --smt-bench=DIR.
+#   smt-bench.py list ARCHIVE...         queries by hit count, with locations
+#   smt-bench.py extract OUT ARCHIVE...  write each query to OUT/<hash>.smt2
+# Queries in several archives are merged by hash.
+
+import argparse
+import collections
+import os
+import struct
+import zlib
+
+parser = argparse.ArgumentParser()
+sub = parser.add_subparsers(dest='cmd', required=True)
+p = sub.add_parser('list', help='list queries by hit count')
+p.add_argument('archives', nargs='+')
+p.add_argument('--top', type=int, default=0,
+               help='only list the N most hit queries')
+p = sub.add_parser('extract', help='write the queries as .smt2 files')
+p.add_argument('out')
+p.add_argument('archives', nargs='+')
+p.add_argument('--min-hits', type=int, default=1,
+               help='only extract queries seen at least N times')
+p.add_argument('--top', type=int, default=0,
+               help='only extract the N most hit queries')
+args = parser.parse_args()
+
+# hash -> (archive, offset)
+stored = {}
+hits = collections.Counter()
+locations = collections.defaultdict(collections.Counter)
+
+for archive in args.archives:
+    with open(os.path.join(archive, 'index')) as f:
+        for line in f:
+            if not line.endswith('\n'):
+                break  # being written
+            h, offset, loc = line.rstrip('\n').split(' ', 2)
+            hits[h] += 1
+            locations[h][loc] += 1
+            if offset != '+' and h not in stored:
+                stored[h] = (archive, int(offset))
+
+queries = sorted(stored, key=lambda h: (-hits[h], h))
+if args.top > 0:
+    queries = queries[:args.top]
+
+
+def read_query(archive, offset):
+    with open(os.path.join(archive, 'queries'), 'rb') as f:
+        f.seek(offset)
+        size, stored_size = struct.unpack('<II', f.read(8))
+        data = f.read(stored_size)
+    return data if size == stored_size else zlib.decompress(data)
+
+
+if args.cmd == 'list':
+    print('{:<32} {:>7} {:>9}  {}'.format('hash', 'hits', 'size',
+                                         'locations'))
+    for h in queries:
+        size = 0
+        archive, offset = stored[h]
+        with open(os.path.join(archive, 'queries'), 'rb') as f:
+            f.seek(offset)
+            size = struct.unpack('<I', f.read(4))[0]
+        locs = ', '.join('{} ({})'.format(loc, n) if n > 1 else loc
+                         for loc, n in locations[h].most_common(3))
+        if len(locations[h]) > 3:
+            locs += ', ...'
+        print('{:<32} {:>7} {:>9}  {}'.format(h, hits[h], size, locs))
+else:
+    os.makedirs(args.out, exist_ok=True)
+    n = 0
+    for h in queries:
+        if hits[h] < args.min_hits:
+            continue
+        with open(os.path.join(args.out, h + '.smt2'), 'wb') as f:
+            f.write(read_query(*stored[h]))
+        n += 1
+    print('Extracted {} queries'.format(n))
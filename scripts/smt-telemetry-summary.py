@@ -0,0 +1,61 @@
+#!/usr/bin/python3
+
+# Summarizes the query logs written by alive-tv --smt-telemetry=FILE: per
+# kind of check (or per function, result or tactic pipeline with --by), the
+# number of queries, their results, total and maximum solve time, and a
+# histogram of solve times.
+
+import argparse
+import collections
+import json
+import math
+
+parser = argparse.ArgumentParser()
+parser.add_argument('logs', nargs='+', help='telemetry files')
+parser.add_argument('--by', choices=['kind', 'fn', 'result', 'tactic'],
+                    default='kind', help='field to group queries by')
+parser.add_argument('--slowest', type=int, default=10,
+                    help='number of slowest queries to list')
+args = parser.parse_args()
+
+queries = []
+for log in args.logs:
+    with open(log) as f:
+        for line in f:
+            queries.append(json.loads(line))
+
+groups = collections.defaultdict(list)
+for q in queries:
+    groups[q[args.by]].append(q)
+
+# histogram buckets: <1ms, <10ms, <100ms, <1s, <10s, >=10s
+buckets = ['<1ms', '<10ms', '<100ms', '<1s', '<10s', '>=10s']
+
+def bucket(seconds):
+    if seconds <= 0:
+        return 0
+    return max(0, min(len(buckets) - 1, math.floor(math.log10(seconds)) + 4))
+
+print('{:<16} {:>7} {:>7} {:>7} {:>7} {:>10} {:>9}  {}'.format(
+      args.by, 'queries', 'unsat', 'sat', 'timeout', 'total(s)', 'max(s)',
+      ' '.join('{:>6}'.format(b) for b in buckets)))
+
+rows = sorted(groups.items(),
+              key=lambda kv: -sum(q['time'] for q in kv[1]))
+for key, qs in rows:
+    results = collections.Counter(q['result'] for q in qs)
+    hist = [0] * len(buckets)
+    for q in qs:
+        hist[bucket(q['time'])] += 1
+    print('{:<16} {:>7} {:>7} {:>7} {:>7} {:>10.3f} {:>9.3f}  {}'.format(
+          key[:16], len(qs), results['unsat'], results['sat'],
+          results['timeout'], sum(q['time'] for q in qs),
+          max(q['time'] for q in qs),
+          ' '.join('{:>6}'.format(n) for n in hist)))
+
+if args.slowest > 0:
+    print('\nSlowest queries:')
+    for q in sorted(queries, key=lambda q: -q['time'])[:args.slowest]:
+        print('  {:>9.3f}s  {:<8} {:<14} nodes={:<7} quant_vars={:<4} {}'
+              .format(q['time'], q['result'], q['kind'], q['nodes'],
+                      q['quant_vars'], q['fn']))
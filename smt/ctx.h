@@ -20,6 +20,7 @@ public:
   void destroy();
 };
 
-extern context ctx;
+// Each thread has its own context, so threads can verify independently.
+extern thread_local context ctx;
 
 }
@@ -9,15 +9,19 @@
 #include <bit>
 #include <cassert>
 #include <climits>
+#include <iomanip>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <z3.h>
 
 #define DEBUG_Z3_RC 0
-#define WARN_MISSING_FOLDS 0
 
-#if DEBUG_Z3_RC || WARN_MISSING_FOLDS
+#if DEBUG_Z3_RC
 # include <iostream>
 #endif
 
@@ -44,19 +48,25 @@ static Z3_ast mkVar(const char *name, Z3_sort sort) {
   return Z3_mk_const(smt::ctx(), Z3_mk_string_symbol(smt::ctx(), name), sort);
 }
 
-static expr simplify_const(expr &&e) { return e.simplifyNoTimeout(); }
+// Set once at startup, while fold_counts is shared by all threads
+static bool count_folds = false;
+// Folds left to Z3 because no fold of ours applied, by Z3 operation name
+static unordered_map<string, uint64_t> fold_counts;
+static mutex fold_counts_lock;
+
+static expr simplify_const(expr &&e) {
+  if (count_folds) {
+    lock_guard lock(fold_counts_lock);
+    ++fold_counts[e.fn_name()];
+  }
+  return e.simplifyNoTimeout();
+}
 
 template <typename... Exprs>
 static expr simplify_const(expr &&e, const expr &input,
                            const Exprs &... inputs) {
   if (input.isConst())
     return simplify_const(std::move(e), inputs...);
-
-#if WARN_MISSING_FOLDS
-  if (!e.isConst() && e.simplify().isConst()) {
-    cout << "\n[WARN] missing fold: " << e << "\n->\n" << e.simplify() << '\n';
-  }
-#endif
   return std::move(e);
 }
 
@@ -1436,22 +1446,6 @@ void expr::operator|=(const expr &rhs) {
   *this = *this || rhs;
 }
 
-expr expr::mk_and(const set<expr> &vals) {
-  expr ret(true);
-  for (auto &e : vals) {
-    ret &= e;
-  }
-  return ret;
-}
-
-expr expr::mk_or(const set<expr> &vals) {
-  expr ret(false);
-  for (auto &e : vals) {
-    ret |= e;
-  }
-  return ret;
-}
-
 expr expr::implies(const expr &rhs) const {
   if (eq(rhs))
     return true;
@@ -1900,16 +1894,91 @@ expr expr::mkLambda(const expr &var, const expr &val) {
   return Z3_mk_lambda_const(ctx(), 1, &ast, val());
 }
 
+// Results of simplify() and simplifyNoTimeout(), by the id of the original
+// term. The entries keep both terms alive, so their ids aren't reused.
+// Allocated on first use and freed by simplify_memo_clear(), as the context
+// may outlive the thread-local destructors.
+using SimplifyMemo = unordered_map<unsigned, pair<expr, expr>>;
+static thread_local SimplifyMemo *simplify_memo = nullptr;
+static thread_local SimplifyStats simplify_stats;
+
+const expr* expr::lookupSimplified() const {
+  if (simplify_memo) {
+    auto I = simplify_memo->find(id());
+    if (I != simplify_memo->end()) {
+      ++simplify_stats.hits;
+      return &I->second.second;
+    }
+  }
+  ++simplify_stats.misses;
+  return nullptr;
+}
+
+void expr::memoSimplified(const expr &e) const {
+  if (!simplify_memo)
+    simplify_memo = new SimplifyMemo;
+  // drop everything rather than tracking usage; vcgen of a function rarely
+  // gets close to this
+  else if (simplify_memo->size() >= 1 << 16)
+    simplify_memo->clear();
+  simplify_memo->try_emplace(id(), *this, e);
+}
+
 expr expr::simplify() const {
   C();
+  if (auto *e = lookupSimplified())
+    return *e;
   auto e = Z3_simplify(ctx(), ast());
   // Z3_simplify returns null on timeout
-  return e ? e : *this;
+  if (!e)
+    return *this;
+  expr r(e);
+  memoSimplified(r);
+  return r;
 }
 
 expr expr::simplifyNoTimeout() const {
   C();
-  return Z3_simplify_ex(ctx(), ast(), ctx.getNoTimeoutParam());
+  if (auto *e = lookupSimplified())
+    return *e;
+  expr r = Z3_simplify_ex(ctx(), ast(), ctx.getNoTimeoutParam());
+  memoSimplified(r);
+  return r;
+}
+
+const SimplifyStats& simplify_get_stats() {
+  return simplify_stats;
+}
+
+void expr_count_folds(bool enable) {
+  count_folds = enable;
+}
+
+void expr_print_fold_stats(ostream &os) {
+  lock_guard lock(fold_counts_lock);
+  if (fold_counts.empty())
+    return;
+
+  vector<pair<string, uint64_t>> ops(fold_counts.begin(), fold_counts.end());
+  sort(ops.begin(), ops.end(), [](auto &a, auto &b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  });
+
+  os << "\n\nConstant folds left to Z3\n"
+        "=========================\n"
+        "Terms whose inputs were all constants, but which were built and then "
+        "folded\nby Z3's simplifier\n\n"
+     << left << setw(24) << "operation" << right << setw(12) << "count"
+     << '\n';
+  for (auto &[op, n] : ops) {
+    os << left << setw(24) << op << right << setw(12) << n << '\n';
+  }
+  os << left;
+}
+
+void simplify_memo_clear() {
+  delete simplify_memo;
+  simplify_memo = nullptr;
 }
 
 expr expr::subst(const vector<pair<expr, expr>> &repls) const {
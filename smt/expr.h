@@ -50,6 +50,9 @@ class expr {
 
   bool alwaysFalse() const { return false; }
 
+  const expr* lookupSimplified() const;
+  void memoSimplified(const expr &e) const;
+
   static Z3_ast mkTrue();
   static Z3_ast mkFalse();
   static expr mkUInt(uint64_t n, Z3_sort sort);
@@ -265,8 +268,23 @@ public:
   void operator&=(const expr &rhs);
   void operator|=(const expr &rhs);
 
-  static expr mk_and(const std::set<expr> &vals);
-  static expr mk_or(const std::set<expr> &vals);
+  template <typename Set>
+  static expr mk_and(const Set &vals) {
+    expr ret(true);
+    for (auto &e : vals) {
+      ret &= e;
+    }
+    return ret;
+  }
+
+  template <typename Set>
+  static expr mk_or(const Set &vals) {
+    expr ret(false);
+    for (auto &e : vals) {
+      ret |= e;
+    }
+    return ret;
+  }
 
   expr implies(const expr &rhs) const;
   expr notImplies(const expr &rhs) const;
@@ -329,6 +347,7 @@ public:
   static expr mkForAll(const std::set<expr> &vars, expr &&val);
   static expr mkLambda(const expr &var, const expr &val);
 
+  // Both are memoized, until the context is reset
   expr simplify() const;
   expr simplifyNoTimeout() const;
 
@@ -368,9 +387,27 @@ public:
   friend class Solver;
   friend class Model;
   friend class FnModel;
+  friend class ParallelCheck;
 };
 
 
+struct SimplifyStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+};
+
+const SimplifyStats& simplify_get_stats();
+// Must be called before the context is destroyed. Solver::check() also calls
+// it, as the memo isn't needed while solving.
+void simplify_memo_clear();
+
+// Counts, by Z3 operation, the constant folds that are left to Z3's
+// simplifier rather than done when building the expression. The counts are
+// shared by all threads; enable them before starting any.
+void expr_count_folds(bool enable);
+void expr_print_fold_stats(std::ostream &os);
+
+
 #define mkIf_fold(c, a, b) \
   mkIf_fold_fn(c, [&]() { return a; }, [&]() { return b; })
 
@@ -5,6 +5,7 @@
 
 #include "smt/expr.h"
 #include "util/compiler.h"
+#include "util/flat_set.h"
 #include <cassert>
 #include <compare>
 #include <map>
@@ -16,8 +17,13 @@
 
 namespace smt {
 
+// These containers are created and merged at every join point, so they are
+// sorted vectors rather than node based.
+template <typename T> using ExprSet = util::flat_set<T>;
+template <typename K, typename V> using ExprMap = util::flat_map<K, V>;
+
 class AndExpr {
-  std::set<expr> exprs;
+  ExprSet<expr> exprs;
 
 public:
   AndExpr() = default;
@@ -38,7 +44,7 @@ public:
 
 
 class OrExpr {
-  std::set<expr> exprs;
+  ExprSet<expr> exprs;
 
 public:
   void add(expr &&e);
@@ -50,7 +56,7 @@ public:
 
 template <typename T>
 class DisjointExpr {
-  std::map<T, expr> vals; // val -> domain
+  ExprMap<T, expr> vals; // val -> domain
   std::optional<T> default_val;
 
 public:
@@ -110,7 +116,7 @@ public:
 // domains
 template <typename T>
 class ChoiceExpr {
-  std::map<T, expr> vals; // val -> domain
+  ExprMap<T, expr> vals; // val -> domain
 
 public:
   template <typename V, typename D>
@@ -163,7 +169,7 @@ public:
 
 
 class FunctionExpr {
-  std::map<expr, expr> fn; // key -> val
+  ExprMap<expr, expr> fn; // key -> val
   std::optional<expr> default_val;
 
 public:
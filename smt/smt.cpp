@@ -6,6 +6,7 @@
 #include "smt/solver.h"
 #include "util/version.h"
 #include <cstdint>
+#include <mutex>
 #include <string>
 #include <z3.h>
 
@@ -14,29 +15,41 @@ using namespace std;
 
 namespace smt {
 
+// Z3's memory manager is shared by all threads, so it's only reset when
+// there's a single context. The lock makes the last context's release atomic
+// with respect to other threads creating theirs.
+static mutex initializers_lock;
+static unsigned num_initializers = 0;
+
 smt_initializer::smt_initializer() {
   init();
 }
 
 void smt_initializer::reset() {
-  destroy();
-  Z3_reset_memory();
+  destroy(Z3_reset_memory);
   init();
 }
 
 smt_initializer::~smt_initializer() {
-  destroy();
-  Z3_finalize_memory();
+  destroy(Z3_finalize_memory);
 }
 
 void smt_initializer::init() {
+  {
+    lock_guard guard(initializers_lock);
+    ++num_initializers;
+  }
   ctx.init();
   solver_init();
 }
 
-void smt_initializer::destroy() {
+void smt_initializer::destroy(void (*release_memory)()) {
+  simplify_memo_clear();
   solver_destroy();
   ctx.destroy();
+  lock_guard guard(initializers_lock);
+  if (--num_initializers == 0)
+    release_memory();
 }
 
 
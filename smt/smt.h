@@ -7,6 +7,8 @@
 
 namespace smt {
 
+// Sets up the SMT context of the calling thread. Each thread that creates
+// expressions or solvers needs one.
 struct smt_initializer {
   smt_initializer();
   ~smt_initializer();
@@ -14,7 +16,7 @@ struct smt_initializer {
 
 private:
   void init();
-  void destroy();
+  void destroy(void (*release_memory)());
 };
 
 
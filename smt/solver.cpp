@@ -3,34 +3,60 @@
 
 #include "smt/solver.h"
 #include "smt/ctx.h"
+#include "smt/smt.h"
 #include "util/compiler.h"
+#include "util/bench_archive.h"
 #include "util/config.h"
-#include "util/file.h"
+#include "util/disk_cache.h"
+#include "util/query_cache.h"
+#include "util/stopwatch.h"
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <z3.h>
 
 using namespace smt;
 using namespace util;
 using namespace std;
 using util::config::dbg;
+namespace fs = std::filesystem;
 
 static bool tactic_verbose = false;
 
-static unsigned num_queries = 0;
-static unsigned num_skips = 0;
-static unsigned num_invalid = 0;
-static unsigned num_trivial = 0;
-static unsigned num_sats = 0;
-static unsigned num_unsats = 0;
-static unsigned num_timeout = 0;
-static unsigned num_errors = 0;
+// Tactics and statistics are per thread, like the SMT context.
+static thread_local unsigned num_queries = 0;
+static thread_local unsigned num_skips = 0;
+static thread_local unsigned num_invalid = 0;
+static thread_local unsigned num_trivial = 0;
+static thread_local unsigned num_sats = 0;
+static thread_local unsigned num_unsats = 0;
+static thread_local unsigned num_timeout = 0;
+static thread_local unsigned num_memout = 0;
+static thread_local unsigned num_errors = 0;
+static thread_local unsigned num_cached = 0;
+static thread_local unsigned num_portfolio_wins = 0;
+
+static thread_local SolverStats stats;
 
 namespace {
 class Tactic {
@@ -77,7 +103,7 @@ class MultiTactic final : public Tactic {
   Z3_goal goal = nullptr;
 
 public:
-  MultiTactic(initializer_list<const char*> ts) : Tactic("skip") {
+  MultiTactic(const vector<const char*> &ts) : Tactic("skip") {
     if (tactic_verbose) {
       goal = Z3_mk_goal(ctx(), true, false, false);
       Z3_goal_inc_ref(ctx(), goal);
@@ -104,15 +130,34 @@ public:
     return Z3_tactic_and_then(ctx(), a.t, b.t);
   }
 
-  void add(Z3_ast ast) {
-    if (tactic_verbose)
-      Z3_goal_assert(ctx(), goal, ast);
+  void orElse(const MultiTactic &other) {
+    *this = Tactic(Z3_tactic_or_else(ctx(), t, other.t));
   }
 
-  void check() {
+  void usingParams(Z3_params params) {
+    *this = Tactic(Z3_tactic_using_params(ctx(), t, params));
+  }
+
+  Z3_solver mkSolver() const {
+    auto s = Z3_mk_solver_from_tactic(ctx(), t);
+    Z3_solver_inc_ref(ctx(), s);
+    return s;
+  }
+
+  // The goal is rebuilt from the solver's assertions on every check, as goals
+  // can't be pushed and popped along with the solver's scopes.
+  void check(Z3_solver s) {
     if (!tactic_verbose)
       return;
 
+    Z3_goal_reset(ctx(), goal);
+    auto fmls = Z3_solver_get_assertions(ctx(), s);
+    Z3_ast_vector_inc_ref(ctx(), fmls);
+    for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), fmls); i != e; ++i) {
+      Z3_goal_assert(ctx(), goal, Z3_ast_vector_get(ctx(), fmls, i));
+    }
+    Z3_ast_vector_dec_ref(ctx(), fmls);
+
     string last_result;
 
     for (auto &t : tactics) {
@@ -123,13 +168,13 @@ public:
       to = Tactic(Z3_tactic_or_else(ctx(), to.t, skip.t));
       auto r = Z3_tactic_apply(ctx(), to.t, goal);
       Z3_apply_result_inc_ref(ctx(), r);
-      reset_solver();
+      Z3_goal_reset(ctx(), goal);
 
       for (unsigned i = 0, e = Z3_apply_result_get_num_subgoals(ctx(), r);
            i != e; ++i) {
         auto ng = Z3_apply_result_get_subgoal(ctx(), r, i);
         for (unsigned ii = 0, ee = Z3_goal_size(ctx(), ng); ii != ee; ++ii) {
-          add(Z3_goal_formula(ctx(), ng, ii));
+          Z3_goal_assert(ctx(), goal, Z3_goal_formula(ctx(), ng, ii));
         }
       }
       Z3_apply_result_dec_ref(ctx(), r);
@@ -143,16 +188,162 @@ public:
       }
     }
   }
+};
+}
 
-  void reset_solver() {
-    if (tactic_verbose)
-      Z3_goal_reset(ctx(), goal);
+static thread_local optional<MultiTactic> tactic;
+
+// Cheaper pipelines for queries that don't need all of the default one.
+enum Pipeline { PIPE_DEFAULT, PIPE_QF, PIPE_QF_BV, PIPE_QF_FP, NUM_PIPES };
+static const char *pipeline_names[] = { "default", "qf", "qf_bv", "qf_fp" };
+static thread_local optional<MultiTactic> tactic_qf, tactic_qf_bv,
+                                          tactic_qf_fp;
+static thread_local unsigned num_by_pipeline[NUM_PIPES];
+
+// Picks the pipeline for fml with a single walk over its DAG.
+static Pipeline select_pipeline(Z3_ast fml) {
+  bool has_fp = false, bv_only = true;
+  unordered_set<unsigned> seen;
+  vector<Z3_ast> todo = { fml };
+  do {
+    auto ast = todo.back();
+    todo.pop_back();
+    if (!seen.emplace(Z3_get_ast_id(ctx(), ast)).second)
+      continue;
+
+    auto kind = Z3_get_ast_kind(ctx(), ast);
+    if (kind != Z3_APP_AST && kind != Z3_NUMERAL_AST)
+      return PIPE_DEFAULT; // quantifiers, lambdas
+
+    switch (Z3_get_sort_kind(ctx(), Z3_get_sort(ctx(), ast))) {
+    case Z3_BOOL_SORT:
+    case Z3_BV_SORT:
+      break;
+    case Z3_FLOATING_POINT_SORT:
+    case Z3_ROUNDING_MODE_SORT:
+      has_fp = true;
+      break;
+    default:
+      bv_only = false;
+      break;
+    }
+
+    if (kind == Z3_NUMERAL_AST)
+      continue;
+
+    auto app = Z3_to_app(ctx(), ast);
+    unsigned num_args = Z3_get_app_num_args(ctx(), app);
+    if (num_args > 0 &&
+        Z3_get_decl_kind(ctx(), Z3_get_app_decl(ctx(), app)) ==
+          Z3_OP_UNINTERPRETED)
+      bv_only = false;
+
+    for (unsigned i = 0; i != num_args; ++i) {
+      todo.emplace_back(Z3_get_app_arg(ctx(), app, i));
+    }
+  } while (!todo.empty());
+
+  return has_fp ? PIPE_QF_FP : (bv_only ? PIPE_QF_BV : PIPE_QF);
+}
+
+// Verdicts of previous queries, keyed by a hash of the query's SMT-LIB text.
+// Verdicts are "unsat", or "timeout <ms>" for queries that timed out with the
+// given timeout.
+static unique_ptr<QueryCache> query_cache;
+static string query_cache_dir;
+
+static unique_ptr<BenchArchive> bench_archive;
+static string bench_archive_dir;
+
+static ofstream telemetry;
+static string telemetry_file;
+
+// The query cache, the benchmark archive and the telemetry log are shared by
+// all threads.
+static mutex shared_files_lock;
+static thread_local string query_fn;
+static thread_local const char *query_kind = "other";
+
+// Returns the number of distinct AST nodes in e and the number of variables
+// bound by its quantifiers.
+static pair<uint64_t, uint64_t> count_nodes(Z3_ast e) {
+  uint64_t num_nodes = 0, num_bound = 0;
+  unordered_set<unsigned> seen;
+  vector<Z3_ast> todo = { e };
+  do {
+    auto ast = todo.back();
+    todo.pop_back();
+    if (!seen.emplace(Z3_get_ast_id(ctx(), ast)).second)
+      continue;
+    ++num_nodes;
+
+    switch (Z3_get_ast_kind(ctx(), ast)) {
+    case Z3_APP_AST: {
+      auto app = Z3_to_app(ctx(), ast);
+      for (unsigned i = 0, e = Z3_get_app_num_args(ctx(), app); i != e; ++i) {
+        todo.emplace_back(Z3_get_app_arg(ctx(), app, i));
+      }
+      break;
+    }
+    case Z3_QUANTIFIER_AST:
+      num_bound += Z3_get_quantifier_num_bound(ctx(), ast);
+      todo.emplace_back(Z3_get_quantifier_body(ctx(), ast));
+      break;
+    default:
+      break;
+    }
+  } while (!todo.empty());
+  return { num_nodes, num_bound };
+}
+
+static void write_json_str(ostream &os, string_view str) {
+  os << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\')
+      os << '\\' << c;
+    else if ((unsigned char)c < 0x20)
+      os << "\\u" << hex << setw(4) << setfill('0') << (unsigned)c << dec;
+    else
+      os << c;
   }
-};
+  os << '"';
 }
 
-static optional<MultiTactic> tactic;
+static void log_query(Z3_ast fml, Pipeline pipeline, float seconds,
+                      int64_t alloc_delta, const char *result) {
+  auto [num_nodes, num_bound] = count_nodes(fml);
+  lock_guard guard(shared_files_lock);
+  if (telemetry_file != config::smt_telemetry_file) {
+    telemetry.close();
+    telemetry.clear();
+    telemetry.open(config::smt_telemetry_file, ios::app);
+    telemetry_file = config::smt_telemetry_file;
+  }
+  if (!telemetry.is_open())
+    return;
+
+  telemetry << "{\"fn\":";
+  write_json_str(telemetry, query_fn);
+  telemetry << ",\"kind\":\"" << query_kind
+            << "\",\"nodes\":" << num_nodes
+            << ",\"quant_vars\":" << num_bound
+            << ",\"tactic\":\"" << pipeline_names[pipeline] << '"'
+            << ",\"time\":" << seconds
+            << ",\"result\":\"" << result
+            << "\",\"mem_delta\":" << alloc_delta
+            << ",\"seed\":" << get_random_seed() << "}\n";
+  // flush before any fork so children don't write our buffer again
+  telemetry.flush();
+}
 
+static void open_query_cache() {
+  lock_guard guard(shared_files_lock);
+  if (query_cache_dir != config::smt_cache_dir) {
+    query_cache = make_unique<QueryCache>(config::smt_cache_dir,
+                                          config::smt_cache_max_size);
+    query_cache_dir = config::smt_cache_dir;
+  }
+}
 
 namespace smt {
 
@@ -252,11 +443,34 @@ void solver_print_queries(bool yes) {
   print_queries = yes;
 }
 
+QueryLabel::QueryLabel(const char *kind) : QueryLabel(query_fn, kind) {}
+
+QueryLabel::QueryLabel(const string &fn, const char *kind)
+  : prev_fn(query_fn), prev_kind(query_kind) {
+  query_fn = fn;
+  query_kind = kind;
+}
+
+QueryLabel::~QueryLabel() {
+  query_fn = std::move(prev_fn);
+  query_kind = prev_kind;
+}
+
+static unsigned portfolio_size = 0;
+void solver_portfolio(unsigned n) {
+  portfolio_size = n;
+}
+
+static bool select_tactics = false;
+void solver_select_tactics(bool yes) {
+  select_tactics = yes;
+}
+
 void solver_tactic_verbose(bool yes) {
   tactic_verbose = yes;
 }
 
-Solver::Solver(bool simple) {
+Solver::Solver(bool simple) : simple(simple) {
   s = simple ? Z3_mk_simple_solver(ctx())
              : Z3_mk_solver_from_tactic(ctx(), tactic->t);
   Z3_solver_inc_ref(ctx(), s);
@@ -264,16 +478,13 @@ Solver::Solver(bool simple) {
 
 Solver::~Solver() {
   Z3_solver_dec_ref(ctx(), s);
-  tactic->reset_solver();
 }
 
 void Solver::add(const expr &e) {
   if (e.isFalse()) {
     is_unsat = true;
   } else if (e.isValid()) {
-    auto ast = e();
-    Z3_solver_assert(ctx(), s, ast);
-    tactic->add(ast);
+    Z3_solver_assert(ctx(), s, e());
   } else {
     valid = false;
   }
@@ -303,7 +514,6 @@ void Solver::block(const Model &m, Solver *sneg) {
 
 void Solver::reset() {
   Z3_solver_reset(ctx(), s);
-  tactic->reset_solver();
 }
 
 expr Solver::assertions() const {
@@ -319,7 +529,366 @@ expr Solver::assertions() const {
   return ret;
 }
 
+// Alternative solver configurations for the portfolio. Configuration 0 is the
+// solver itself; the others vary the random seed, drop the more expensive
+// preprocessing, or bit-blast to the SAT solver when the query allows it.
+static Z3_solver mk_portfolio_solver(unsigned config) {
+  optional<MultiTactic> t;
+  switch (config % 3) {
+  case 0:
+    t.emplace(initializer_list<const char*>{
+      "simplify", "propagate-values", "simplify", "elim-uncnstr", "simplify",
+      "qfbv"
+    });
+    // fall back to the default pipeline if the query isn't pure bit-vectors
+    t->orElse(*tactic);
+    break;
+  case 1:
+    t.emplace(initializer_list<const char*>{
+      "simplify", "propagate-values", "simplify", "elim-uncnstr", "qe-light",
+      "simplify", "elim-uncnstr", "reduce-args", "qe-light", "simplify", "smt"
+    });
+    break;
+  case 2:
+    t.emplace(initializer_list<const char*>{
+      "simplify", "propagate-values", "simplify", "reduce-args", "simplify",
+      "smt"
+    });
+    break;
+  }
+
+  auto params = Z3_mk_params(ctx());
+  Z3_params_inc_ref(ctx(), params);
+  Z3_params_set_uint(ctx(), params, Z3_mk_string_symbol(ctx(), "random_seed"),
+                     strtoul(get_random_seed(), nullptr, 10) + config);
+  t->usingParams(params);
+  Z3_params_dec_ref(ctx(), params);
+  return t->mkSolver();
+}
+
+namespace {
+// Z3 only enforces its memory limit at a few points, and past it errors out
+// or gets the process killed. Instead, a single watchdog thread interrupts a
+// running check once Z3 uses more than the memory limit (see
+// set_memory_limit).
+// Z3 only reports the allocation of the whole process, which is shared by the
+// checks of all threads. So the watchdog interrupts one check at a time: the
+// one that started at the lowest allocation, during which most of the memory
+// was allocated. Other checks are only interrupted if the allocation is still
+// past the limit a while after that one returns, as its memory is released
+// with its solver.
+class MemoryWatchdog {
+  struct Check {
+    Z3_context ctx;
+    uint64_t alloc_start;
+    bool interrupted = false;
+  };
+  mutex lock;
+  condition_variable cv;
+  unordered_map<unsigned, Check> checks;
+  unsigned next_id = 0;
+  bool running = false;
+  chrono::steady_clock::time_point quiet_until;
+
+  void run() {
+    unique_lock guard(lock);
+    while (true) {
+      // poll every 10ms while there are checks running
+      if (checks.empty())
+        cv.wait(guard, [&]() { return !checks.empty(); });
+      else
+        cv.wait_for(guard, chrono::milliseconds(10));
+      if (checks.empty() || chrono::steady_clock::now() < quiet_until ||
+          !hit_memory_limit())
+        continue;
+
+      Check *victim = nullptr;
+      for (auto &[id, check] : checks) {
+        if (check.interrupted) {
+          victim = nullptr;
+          break;
+        }
+        if (!victim || check.alloc_start < victim->alloc_start)
+          victim = &check;
+      }
+      if (victim) {
+        victim->interrupted = true;
+        Z3_interrupt(victim->ctx);
+      }
+    }
+  }
+
+  // Never destroyed, so the thread can outlive static destructors
+  static MemoryWatchdog *instance;
+
+public:
+  static MemoryWatchdog& get() {
+    static once_flag once;
+    call_once(once, []() {
+      instance = new MemoryWatchdog;
+      // Threads don't survive fork, and the condition variable may be left
+      // with waiters of the parent's thread, so children start over with a
+      // new watchdog.
+      pthread_atfork(nullptr, nullptr,
+                     []() { instance = new MemoryWatchdog; });
+    });
+    return *instance;
+  }
+
+  unsigned start(Z3_context c) {
+    lock_guard guard(lock);
+    if (!running) {
+      thread(&MemoryWatchdog::run, this).detach();
+      running = true;
+    }
+    unsigned id = next_id++;
+    checks.emplace(id, Check{ c, Z3_get_estimated_alloc_size() });
+    cv.notify_one();
+    return id;
+  }
+
+  // Returns whether the check was interrupted
+  bool finish(unsigned id) {
+    lock_guard guard(lock);
+    auto I = checks.find(id);
+    bool interrupted = I->second.interrupted;
+    checks.erase(I);
+    if (interrupted)
+      quiet_until = chrono::steady_clock::now() + chrono::milliseconds(100);
+    return interrupted;
+  }
+};
+
+MemoryWatchdog *MemoryWatchdog::instance = nullptr;
+}
+
+static bool memory_governor = false;
+void solver_memory_governor(bool yes) {
+  memory_governor = yes;
+}
+
+// Runs the check under the memory watchdog if enabled. memout is set if the
+// watchdog interrupted the check before it finished.
+static Z3_lbool check_memory_governed(Z3_solver s, bool &memout) {
+  memout = false;
+  if (!memory_governor)
+    return Z3_solver_check(ctx(), s);
+
+  auto &watchdog = MemoryWatchdog::get();
+  unsigned id = watchdog.start(ctx());
+  auto res = Z3_solver_check(ctx(), s);
+  if (watchdog.finish(id)) {
+    // The interrupt may have arrived just after the check finished, in which
+    // case it sticks to the context until the next check.
+    auto empty = Z3_mk_simple_solver(ctx());
+    Z3_solver_inc_ref(ctx(), empty);
+    Z3_solver_check(ctx(), empty);
+    Z3_solver_dec_ref(ctx(), empty);
+    memout = res == Z3_L_UNDEF;
+  }
+  return res;
+}
+
+static Z3_lbool check_portfolio_config(unsigned config, Z3_ast fml,
+                                       Z3_solver &s, bool &memout) {
+  s = mk_portfolio_solver(config);
+  Z3_solver_assert(ctx(), s, fml);
+  return check_memory_governed(s, memout);
+}
+
+// Races s against portfolio_size - 1 forked children running the other
+// configurations. Returns the first definitive verdict and sets answer to a
+// solver the model or the reason for unknown can be taken from, which the
+// caller must release if it isn't s.
+// Models can't be sent between processes, so if a child finds the query
+// satisfiable first, its configuration is rerun in this process.
+static Z3_lbool check_portfolio(Z3_solver s, Z3_ast fml,
+                                Z3_solver &answer, bool &memout) {
+  vector<pid_t> pids;
+  vector<pollfd> fds;
+  for (unsigned config = 1; config < portfolio_size; ++config) {
+    int pipefd[2];
+    if (pipe(pipefd) != 0)
+      break;
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(pipefd[0]);
+      Z3_solver child_s;
+      bool child_memout;
+      char verdict;
+      switch (check_portfolio_config(config, fml, child_s, child_memout)) {
+      case Z3_L_FALSE: verdict = 'u'; break;
+      case Z3_L_TRUE:  verdict = 's'; break;
+      default:         verdict = '?'; break;
+      }
+      (void)!write(pipefd[1], &verdict, 1);
+      _exit(0);
+    }
+    close(pipefd[1]);
+    if (pid < 0) {
+      close(pipefd[0]);
+      break;
+    }
+    pids.push_back(pid);
+    fds.push_back({ pipefd[0], POLLIN, 0 });
+  }
+
+  // Interrupt our own check as soon as a child has a definitive verdict.
+  mutex lock;
+  bool done = false;
+  int winner = -1;
+  char winner_verdict = 0;
+  Z3_context c = ctx();
+  thread watcher([&]() {
+    unsigned open = fds.size();
+    while (open > 0) {
+      if (poll(fds.data(), fds.size(), 50) <= 0)
+        continue;
+      for (unsigned i = 0; i < fds.size(); ++i) {
+        if (fds[i].fd < 0 || !fds[i].revents)
+          continue;
+        char verdict;
+        if (read(fds[i].fd, &verdict, 1) == 1 &&
+            (verdict == 'u' || verdict == 's')) {
+          lock_guard guard(lock);
+          if (!done) {
+            winner = i + 1;
+            winner_verdict = verdict;
+            Z3_interrupt(c);
+          }
+          return;
+        }
+        close(fds[i].fd);
+        fds[i].fd = -1;
+        --open;
+      }
+    }
+  });
+
+  auto res = check_memory_governed(s, memout);
+  {
+    lock_guard guard(lock);
+    done = true;
+  }
+  for (pid_t pid : pids) {
+    kill(pid, SIGKILL);
+  }
+  watcher.join();
+
+  for (pid_t pid : pids) {
+    waitpid(pid, nullptr, 0);
+  }
+
+  // The interrupt may have arrived just after our check finished, in which
+  // case it sticks to the context until the next check.
+  if (winner >= 0) {
+    auto empty = Z3_mk_simple_solver(ctx());
+    Z3_solver_inc_ref(ctx(), empty);
+    Z3_solver_check(ctx(), empty);
+    Z3_solver_dec_ref(ctx(), empty);
+  }
+  for (auto &fd : fds) {
+    if (fd.fd >= 0)
+      close(fd.fd);
+  }
+
+  answer = s;
+  // Z3 reports the interrupt as "interrupted" or "canceled" depending on the
+  // version, and our check may have timed out before the child's verdict
+  // came; either way the child's verdict stands.
+  if (res != Z3_L_UNDEF || winner < 0)
+    return res;
+
+  ++num_portfolio_wins;
+  if (winner_verdict == 'u')
+    return Z3_L_FALSE;
+  return check_portfolio_config(winner, fml, answer, memout);
+}
+
+// Pipelines are created on first use: creating tactics affects the terms
+// Z3 creates afterwards, and so how fast the default pipeline solves queries.
+static void init_pipeline(Pipeline pipeline) {
+  switch (pipeline) {
+  case PIPE_QF:
+    // without qe-light, which only helps quantified queries
+    tactic_qf.emplace({
+      "simplify",
+      "propagate-values",
+      "simplify",
+      "elim-uncnstr",
+      "simplify",
+      "elim-uncnstr",
+      "reduce-args",
+      "simplify",
+      "smt"
+    });
+    break;
+  case PIPE_QF_BV:
+    // bit-vectors only: no functions to reduce arguments of
+    tactic_qf_bv.emplace({
+      "simplify",
+      "propagate-values",
+      "simplify",
+      "elim-uncnstr",
+      "simplify",
+      "qfbv"
+    });
+    break;
+  case PIPE_QF_FP:
+    // lower floating-point to bit-vectors before the usual preprocessing
+    tactic_qf_fp.emplace({
+      "simplify",
+      "propagate-values",
+      "fpa2bv",
+      "simplify",
+      "elim-uncnstr",
+      "simplify",
+      "elim-uncnstr",
+      "reduce-args",
+      "simplify",
+      "smt"
+    });
+    break;
+  default:
+    UNREACHABLE();
+  }
+}
+
+// Queued queries are named by their hash, so a query that times out several
+// times is only retried once. The header records where the query comes from
+// and the timeout it has been tried with.
+static const char retry_header[] = ";; alive-retry ";
+
+// The kinds of the checks of check_refinement() in tools/transform.cpp whose
+// models are counterexamples to the refinement. SAT answers to the other
+// queries, such as the precondition one, are expected.
+static bool is_refinement_check(string_view kind) {
+  for (auto k : { "ub", "return_domain", "poison", "undef", "value",
+                  "memory" }) {
+    if (kind == k)
+      return true;
+  }
+  return false;
+}
+
+static void queue_retry(const string &query, uint64_t timeout) {
+  error_code ec;
+  fs::create_directories(config::smt_retry_dir, ec);
+
+  auto name = to_hex(hash_data(query));
+  ofstream file(fs::path(config::smt_retry_dir) / (name + ".smt2"));
+  file << retry_header << "fn: " << query_fn << '\n'
+       << retry_header << "kind: " << query_kind << '\n'
+       << retry_header << "timeout: " << timeout << '\n'
+       << query;
+}
+
 Result Solver::check() const {
+  // The simplify memo only helps while building formulas. Its terms would
+  // otherwise stay alive during the check and count against Z3's memory
+  // limit.
+  simplify_memo_clear();
+
   if (!valid) {
     ++num_invalid;
     return Result::INVALID;
@@ -330,21 +899,29 @@ Result Solver::check() const {
     return Result::UNSAT;
   }
 
-  if (!config::smt_benchmark_dir.empty()) {
+  // Queries are only serialized if needed, and the retry queue only needs
+  // the ones that time out.
+  auto serialize = [&]() -> string {
     const char *banner =
     R"(Alive2 compiler optimization refinement query
 ; More info in "Alive2: Bounded Translation Validation for LLVM", PLDI'21.)";
     expr fml = assertions();
-    if (!fml.isTrue()) {
-      auto str = Z3_benchmark_to_smtlib_string(ctx(), banner, nullptr, nullptr,
-                                               nullptr, 0, nullptr, fml());
-      ofstream file(get_random_filename(config::smt_benchmark_dir, "smt2"));
-      if (!file.is_open()) {
-        dbg() << "Alive2: Couldn't open smtlib benchmark file!" << endl;
-        exit(1);
-      }
-      file << str;
+    if (fml.isTrue())
+      return {};
+    return Z3_benchmark_to_smtlib_string(ctx(), banner, nullptr, nullptr,
+                                         nullptr, 0, nullptr, fml());
+  };
+  string query;
+  if (!config::smt_benchmark_dir.empty() || !config::smt_cache_dir.empty())
+    query = serialize();
+
+  if (!config::smt_benchmark_dir.empty() && !query.empty()) {
+    lock_guard guard(shared_files_lock);
+    if (bench_archive_dir != config::smt_benchmark_dir) {
+      bench_archive = make_unique<BenchArchive>(config::smt_benchmark_dir);
+      bench_archive_dir = config::smt_benchmark_dir;
     }
+    bench_archive->add(query, query_fn + ' ' + query_kind);
   }
 
   if (config::skip_smt) {
@@ -352,27 +929,125 @@ Result Solver::check() const {
     return Result::SKIP;
   }
 
+  // SAT verdicts are not cached, since the caller needs a model.
+  optional<QueryCache::Key> cache_key;
+  uint64_t timeout = strtoull(get_query_timeout(), nullptr, 10);
+  if (!config::smt_cache_dir.empty() && !query.empty()) {
+    open_query_cache();
+    cache_key = hash_data(query);
+    if (auto verdict = query_cache->get(*cache_key)) {
+      string_view entry = *verdict;
+      if (entry == "unsat") {
+        ++num_cached;
+        return Result::UNSAT;
+      }
+      if (entry.starts_with("timeout ") &&
+          strtoull(string(entry.substr(8)).c_str(), nullptr, 10) >= timeout) {
+        ++num_cached;
+        return Result::TIMEOUT;
+      }
+    }
+  }
+
   ++num_queries;
   if (print_queries)
     dbg() << "\nSMT query:\n" << Z3_solver_to_string(ctx(), s) << endl;
 
-  tactic->check();
+  tactic->check(s);
 
-  switch (Z3_solver_check(ctx(), s)) {
+  uint64_t alloc_before = Z3_get_estimated_alloc_size();
+  StopWatch sw;
+  Z3_solver solver = s;
+  auto pipeline = PIPE_DEFAULT;
+  if (select_tactics && !simple && !tactic_verbose) {
+    expr fml = assertions();
+    pipeline = select_pipeline(fml());
+    if (pipeline != PIPE_DEFAULT) {
+      auto &t = pipeline == PIPE_QF    ? tactic_qf :
+                pipeline == PIPE_QF_BV ? tactic_qf_bv : tactic_qf_fp;
+      if (!t)
+        init_pipeline(pipeline);
+      solver = t->mkSolver();
+      Z3_solver_assert(ctx(), solver, fml());
+    }
+  }
+  ++num_by_pipeline[pipeline];
+
+  Z3_solver answer = solver;
+  Z3_lbool res;
+  bool memout;
+  if (portfolio_size > 1) {
+    expr fml = assertions();
+    res = check_portfolio(solver, fml(), answer, memout);
+  } else {
+    res = check_memory_governed(solver, memout);
+  }
+  sw.stop();
+  // release the pipeline and portfolio solvers, if any, after taking the
+  // answer
+  auto release = [&]() {
+    if (answer != solver)
+      Z3_solver_dec_ref(ctx(), answer);
+    if (solver != s)
+      Z3_solver_dec_ref(ctx(), solver);
+  };
+  ++stats.num_queries;
+  stats.wall_seconds += sw.seconds();
+  stats.cpu_seconds += sw.cpu_seconds();
+  stats.query_seconds.emplace_back(sw.seconds(), sw.cpu_seconds());
+  stats.peak_alloc_size =
+    max(stats.peak_alloc_size, uint64_t(Z3_get_estimated_alloc_size()));
+
+  if (!config::smt_telemetry_file.empty()) {
+    const char *result = "error";
+    if (res == Z3_L_FALSE)
+      result = "unsat";
+    else if (res == Z3_L_TRUE)
+      result = "sat";
+    else if (memout)
+      result = "memout";
+    else if (string_view(Z3_solver_get_reason_unknown(ctx(), answer)) ==
+               "timeout")
+      result = "timeout";
+    expr fml = assertions();
+    log_query(fml(), pipeline, sw.seconds(),
+              int64_t(Z3_get_estimated_alloc_size() - alloc_before), result);
+  }
+
+  switch (res) {
   case Z3_L_FALSE:
     ++num_unsats;
+    release();
+    if (cache_key)
+      query_cache->put(*cache_key, "unsat");
     return Result::UNSAT;
-  case Z3_L_TRUE:
+  case Z3_L_TRUE: {
     ++num_sats;
-    return Z3_solver_get_model(ctx(), s);
+    Result r(Z3_solver_get_model(ctx(), answer));
+    release();
+    return r;
+  }
   case Z3_L_UNDEF: {
-    string_view reason = Z3_solver_get_reason_unknown(ctx(), s);
+    string reason = Z3_solver_get_reason_unknown(ctx(), answer);
+    release();
+    if (memout) {
+      ++num_memout;
+      return Result::MEMOUT;
+    }
     if (reason == "timeout") {
       ++num_timeout;
+      if (cache_key)
+        query_cache->put(*cache_key, "timeout " + to_string(timeout));
+      if (!config::smt_retry_dir.empty()) {
+        if (query.empty())
+          query = serialize();
+        if (!query.empty())
+          queue_retry(query, timeout);
+      }
       return Result::TIMEOUT;
     }
     ++num_errors;
-    return { Result::ERROR, string(reason) };
+    return { Result::ERROR, std::move(reason) };
   }
   default:
     UNREACHABLE();
@@ -397,11 +1072,357 @@ SolverPush::~SolverPush() {
 }
 
 
+// The counters of the query statistics, which forked checks send back
+static vector<unsigned*> query_counters() {
+  vector<unsigned*> counters = {
+    &num_queries, &num_skips, &num_invalid, &num_trivial, &num_sats,
+    &num_unsats, &num_timeout, &num_memout, &num_errors, &num_cached,
+    &num_portfolio_wins, &stats.num_queries
+  };
+  for (auto &n : num_by_pipeline) {
+    counters.push_back(&n);
+  }
+  return counters;
+}
+
+template <typename T>
+static void append_raw(string &s, const T &v) {
+  s.append((const char*)&v, sizeof(v));
+}
+
+template <typename T>
+static bool read_raw(string_view &s, T &v) {
+  if (s.size() < sizeof(v))
+    return false;
+  memcpy(&v, s.data(), sizeof(v));
+  s.remove_prefix(sizeof(v));
+  return true;
+}
+
+ParallelCheck::ParallelCheck(Solver &s, const vector<expr> &fmls,
+                             const vector<const char*> &kinds)
+  : s(s), fmls(fmls), kinds(kinds), msgs(fmls.size()) {
+  for (unsigned i = 0; i < fmls.size(); ++i) {
+    int pipefd[2];
+    pid_t pid = -1;
+    if (pipe(pipefd) == 0) {
+      pid = fork();
+      if (pid == 0) {
+        close(pipefd[0]);
+        auto counters = query_counters();
+        vector<unsigned> counts_before;
+        for (auto *n : counters) {
+          counts_before.push_back(*n);
+        }
+        auto stats_before = stats;
+
+        Result r;
+        {
+          QueryLabel label(kinds[i]);
+          SolverPush push(s);
+          s.add(fmls[i]);
+          r = s.check();
+        }
+
+        string msg(1, char(r.a));
+        for (unsigned j = 0; j < counters.size(); ++j) {
+          append_raw(msg, *counters[j] - counts_before[j]);
+        }
+        append_raw(msg, stats.wall_seconds - stats_before.wall_seconds);
+        append_raw(msg, stats.cpu_seconds - stats_before.cpu_seconds);
+        append_raw(msg, stats.peak_alloc_size);
+        auto &secs = stats.query_seconds;
+        auto secs_before = stats_before.query_seconds.size();
+        append_raw(msg, unsigned(secs.size() - secs_before));
+        for (auto j = secs_before; j < secs.size(); ++j) {
+          append_raw(msg, secs[j]);
+        }
+        if (r.isError())
+          msg += r.reason;
+        else if (r.isSat()) {
+          // the model's values of the constants as an SMT-LIB query
+          expr eqs = true;
+          for (auto [var, val] : r.getModel()) {
+            // refers to a function that isn't part of the query
+            if (Z3_is_as_array(ctx(), val()))
+              continue;
+            eqs &= var == val;
+          }
+          msg += Z3_benchmark_to_smtlib_string(ctx(), "", nullptr, nullptr,
+                                               nullptr, 0, nullptr, eqs());
+        }
+
+        for (string_view data(msg); !data.empty(); ) {
+          auto n = write(pipefd[1], data.data(), data.size());
+          if (n <= 0)
+            break;
+          data.remove_prefix(n);
+        }
+        _exit(0);
+      }
+      close(pipefd[1]);
+      if (pid < 0)
+        close(pipefd[0]);
+    }
+    // checked in this process instead if the fork failed
+    pids.push_back(pid);
+    fds.push_back(pid < 0 ? -1 : pipefd[0]);
+  }
+}
+
+ParallelCheck::~ParallelCheck() {
+  for (unsigned i = 0; i < pids.size(); ++i) {
+    kill(i);
+  }
+}
+
+void ParallelCheck::kill(unsigned i) {
+  if (pids[i] < 0)
+    return;
+  ::kill(pids[i], SIGKILL);
+  waitpid(pids[i], nullptr, 0);
+  close(fds[i]);
+  pids[i] = -1;
+}
+
+// Reads the message of the i-th process, which must have sent it or exited,
+// and merges its statistics into ours.
+void ParallelCheck::receive(unsigned i) {
+  string msg;
+  char buf[4096];
+  ssize_t n;
+  while ((n = read(fds[i], buf, sizeof(buf))) > 0) {
+    msg.append(buf, n);
+  }
+  waitpid(pids[i], nullptr, 0);
+  close(fds[i]);
+  pids[i] = -1;
+
+  string_view data(msg);
+  char answer;
+  auto counters = query_counters();
+  vector<unsigned> counts(counters.size());
+  float wall, cpu;
+  uint64_t peak_alloc;
+  unsigned num_secs;
+  bool ok = read_raw(data, answer);
+  for (auto &n : counts) {
+    ok = ok && read_raw(data, n);
+  }
+  ok = ok && read_raw(data, wall) && read_raw(data, cpu) &&
+       read_raw(data, peak_alloc) && read_raw(data, num_secs);
+  vector<pair<float, float>> secs(ok ? num_secs : 0);
+  for (auto &sec : secs) {
+    ok = ok && read_raw(data, sec);
+  }
+  // the process crashed
+  if (!ok)
+    return;
+
+  for (unsigned j = 0; j < counters.size(); ++j) {
+    *counters[j] += counts[j];
+  }
+  stats.wall_seconds += wall;
+  stats.cpu_seconds += cpu;
+  stats.peak_alloc_size = max(stats.peak_alloc_size, peak_alloc);
+  stats.query_seconds.insert(stats.query_seconds.end(), secs.begin(),
+                             secs.end());
+  msgs[i] = answer;
+  msgs[i] += data;
+
+  // the results after a SAT one won't be taken
+  if (answer == Result::SAT) {
+    for (unsigned j = i + 1; j < pids.size(); ++j) {
+      kill(j);
+    }
+  }
+}
+
+Result ParallelCheck::get(unsigned i) {
+  // Receive the results of the other processes as they come, so we can kill
+  // those that aren't needed anymore as soon as possible.
+  while (pids[i] >= 0) {
+    vector<pollfd> polled;
+    vector<unsigned> idx;
+    for (unsigned j = 0; j < pids.size(); ++j) {
+      if (pids[j] >= 0) {
+        polled.push_back({ fds[j], POLLIN, 0 });
+        idx.push_back(j);
+      }
+    }
+    if (poll(polled.data(), polled.size(), -1) <= 0)
+      continue;
+    for (unsigned j = 0; j < polled.size(); ++j) {
+      if (polled[j].revents && pids[idx[j]] >= 0)
+        receive(idx[j]);
+    }
+  }
+
+  auto &msg = msgs[i];
+  if (!msg.empty() && msg[0] != Result::SAT)
+    return { Result::answer(msg[0]), msg.substr(1) };
+
+  QueryLabel label(kinds[i]);
+  SolverPush push(s);
+  s.add(fmls[i]);
+  if (!msg.empty()) {
+    SolverPush push_model(s);
+    auto model = Z3_parse_smtlib2_string(ctx(), msg.c_str() + 1, 0, nullptr,
+                                         nullptr, 0, nullptr, nullptr);
+    Z3_ast_vector_inc_ref(ctx(), model);
+    for (unsigned j = 0, e = Z3_ast_vector_size(ctx(), model); j != e; ++j) {
+      Z3_solver_assert(ctx(), s.s, Z3_ast_vector_get(ctx(), model, j));
+    }
+    Z3_ast_vector_dec_ref(ctx(), model);
+    auto r = s.check();
+    if (r.isSat())
+      return r;
+  }
+  return s.check();
+}
+
+
+RetryStats solver_retry_queue(const string &dir, unsigned max_timeout,
+                              ostream &os) {
+  error_code ec;
+  vector<fs::path> files;
+  for (auto &entry : fs::directory_iterator(dir, ec)) {
+    if (entry.path().extension() == ".smt2")
+      files.emplace_back(entry.path());
+  }
+  sort(files.begin(), files.end());
+
+  if (!config::smt_cache_dir.empty())
+    open_query_cache();
+
+  RetryStats retry;
+  unsigned base_seed = strtoul(get_random_seed(), nullptr, 10);
+
+  for (auto &path : files) {
+    string contents;
+    {
+      ifstream file(path);
+      contents.assign(istreambuf_iterator<char>(file),
+                      istreambuf_iterator<char>());
+    }
+
+    // split off the header
+    string fn, kind;
+    uint64_t timeout = 0;
+    size_t start = 0;
+    while (string_view(contents).substr(start).starts_with(retry_header)) {
+      size_t end = contents.find('\n', start);
+      if (end == string::npos)
+        break;
+      string_view line(contents.data() + start, end - start);
+      line.remove_prefix(sizeof(retry_header) - 1);
+      if (line.starts_with("fn: "))
+        fn = line.substr(4);
+      else if (line.starts_with("kind: "))
+        kind = line.substr(6);
+      else if (line.starts_with("timeout: "))
+        timeout = strtoull(string(line.substr(9)).c_str(), nullptr, 10);
+      start = end + 1;
+    }
+    string query = contents.substr(start);
+
+    if (max(timeout, uint64_t(1)) * 4 > max_timeout) {
+      os << path.filename().string() << ": not retried, timeout " << timeout
+         << "ms is already the largest " << fn << ' ' << kind << '\n';
+      ++retry.num_queued;
+      continue;
+    }
+
+    auto fmls = Z3_parse_smtlib2_string(ctx(), query.c_str(), 0, nullptr,
+                                        nullptr, 0, nullptr, nullptr);
+    Z3_ast_vector_inc_ref(ctx(), fmls);
+
+    // geometrically growing timeouts with a different seed each time
+    Z3_lbool res = Z3_L_UNDEF;
+    string reason;
+    bool memout = false;
+    StopWatch sw;
+    unsigned attempt = 0;
+    uint64_t tried = timeout;
+    for (uint64_t to = max(timeout, uint64_t(1)) * 4; to <= max_timeout;
+         to *= 4) {
+      ++attempt;
+      auto params = Z3_mk_params(ctx());
+      Z3_params_inc_ref(ctx(), params);
+      Z3_params_set_uint(ctx(), params, Z3_mk_string_symbol(ctx(), "timeout"),
+                         to);
+      Z3_params_set_uint(ctx(), params,
+                         Z3_mk_string_symbol(ctx(), "random_seed"),
+                         base_seed + attempt);
+      auto s = tactic->mkSolver();
+      Z3_solver_set_params(ctx(), s, params);
+      Z3_params_dec_ref(ctx(), params);
+      for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), fmls); i != e; ++i) {
+        Z3_solver_assert(ctx(), s, Z3_ast_vector_get(ctx(), fmls, i));
+      }
+      res = check_memory_governed(s, memout);
+      if (res == Z3_L_UNDEF)
+        reason = memout ? "memout" : Z3_solver_get_reason_unknown(ctx(), s);
+      Z3_solver_dec_ref(ctx(), s);
+      tried = to;
+      if (res != Z3_L_UNDEF || reason != "timeout")
+        break;
+    }
+    sw.stop();
+    Z3_ast_vector_dec_ref(ctx(), fmls);
+
+    const char *verdict = "timeout";
+    if (res == Z3_L_FALSE)
+      verdict = "unsat";
+    else if (res == Z3_L_TRUE)
+      verdict = "sat";
+    else if (memout)
+      verdict = "memout";
+    else if (reason != "timeout")
+      verdict = "error";
+
+    bool incorrect = res == Z3_L_TRUE && is_refinement_check(kind);
+    os << path.filename().string() << ": " << verdict << " after " << attempt
+       << " attempts (" << fixed << setprecision(1) << sw.seconds()
+       << "s, timeout " << tried << "ms) " << fn << ' ' << kind;
+    if (incorrect)
+      os << " -- the transformation is incorrect!";
+    os << '\n';
+
+    auto key = hash_data(query);
+    if (res == Z3_L_UNDEF) {
+      // Unsolved queries stay queued: timeouts for a larger budget, memouts
+      // for more memory, and errors for a look.
+      if (reason == "timeout") {
+        if (query_cache)
+          query_cache->put(key, "timeout " + to_string(tried));
+        ofstream file(path);
+        file << retry_header << "fn: " << fn << '\n'
+             << retry_header << "kind: " << kind << '\n'
+             << retry_header << "timeout: " << tried << '\n'
+             << query;
+      }
+      ++retry.num_queued;
+      continue;
+    }
+
+    // SAT verdicts are recorded only to replace the timeout entry; the next
+    // run still needs to solve the query itself to get a model.
+    if (query_cache)
+      query_cache->put(key, res == Z3_L_FALSE ? "unsat" : "sat");
+    ++retry.num_solved;
+    retry.num_incorrect += incorrect;
+    fs::remove(path, ec);
+  }
+  return retry;
+}
+
 void solver_print_stats(ostream &os) {
   float total = num_queries / 100.0;
   float trivial_pc = num_queries == 0 ? 0 :
                        (num_trivial * 100.0) / (num_trivial + num_queries);
   float to_pc      = num_queries == 0 ? 0 : num_timeout / total;
+  float memout_pc  = num_queries == 0 ? 0 : num_memout / total;
   float error_pc   = num_queries == 0 ? 0 : num_errors / total;
   float sat_pc     = num_queries == 0 ? 0 : num_sats / total;
   float unsat_pc   = num_queries == 0 ? 0 : num_unsats / total;
@@ -412,10 +1433,29 @@ void solver_print_stats(ostream &os) {
         "Num invalid: " << num_invalid << "\n"
         "Num skips:   " << num_skips << "\n"
         "Num trivial: " << num_trivial << " (" << trivial_pc << "%)\n"
+        "Num cached:  " << num_cached << "\n"
+        "Num won by portfolio: " << num_portfolio_wins << "\n"
         "Num timeout: " << num_timeout << " (" << to_pc << "%)\n"
+        "Num memout:  " << num_memout << " (" << memout_pc << "%)\n"
         "Num errors:  " << num_errors << " (" << error_pc << "%)\n"
         "Num SAT:     " << num_sats << " (" << sat_pc << "%)\n"
-        "Num UNSAT:   " << num_unsats << " (" << unsat_pc << "%)\n";
+        "Num UNSAT:   " << num_unsats << " (" << unsat_pc << "%)\n"
+        "Tactic pipelines:";
+  for (unsigned i = 0; i < NUM_PIPES; ++i) {
+    os << (i == 0 ? " " : ", ") << pipeline_names[i] << ' '
+       << num_by_pipeline[i];
+  }
+  auto &simp = simplify_get_stats();
+  os << "\nSimplify memo: " << simp.hits << " hits, " << simp.misses
+     << " misses\n";
+}
+
+const SolverStats& solver_get_stats() {
+  return stats;
+}
+
+void solver_reset_stats() {
+  stats = SolverStats();
 }
 
 
@@ -428,24 +1468,89 @@ EnableSMTQueriesTMP::~EnableSMTQueriesTMP() {
 }
 
 
+static const vector<const char*> default_tactics = {
+  "simplify",
+  "propagate-values",
+  "simplify",
+  "elim-uncnstr",
+  "qe-light",
+  "simplify",
+  "elim-uncnstr",
+  "reduce-args",
+  "qe-light",
+  "simplify",
+  "smt"
+};
+
+static void set_param(Z3_params params, const string &name,
+                      const string &value) {
+  auto sym = Z3_mk_string_symbol(ctx(), name.c_str());
+  char *end;
+  if (value == "true" || value == "false") {
+    Z3_params_set_bool(ctx(), params, sym, value == "true");
+  } else if (!value.empty() &&
+             value.find_first_not_of("0123456789") == string::npos) {
+    Z3_params_set_uint(ctx(), params, sym, strtoul(value.c_str(), nullptr, 10));
+  } else if (double d = strtod(value.c_str(), &end);
+             !value.empty() && *end == '\0') {
+    Z3_params_set_double(ctx(), params, sym, d);
+  } else {
+    Z3_params_set_symbol(ctx(), params, sym,
+                         Z3_mk_string_symbol(ctx(), value.c_str()));
+  }
+}
+
+string solver_check_smtlib(const string &query, const vector<string> &tactics,
+                           const vector<string> &params, unsigned timeout) {
+  auto p = Z3_mk_params(ctx());
+  Z3_params_inc_ref(ctx(), p);
+  set_param(p, "random_seed", get_random_seed());
+  for (auto &param : params) {
+    auto eq = param.find('=');
+    set_param(p, param.substr(0, eq),
+              eq == string::npos ? "true" : param.substr(eq + 1));
+  }
+  set_param(p, "timeout", to_string(timeout));
+
+  vector<const char*> names;
+  for (auto &t : tactics) {
+    names.emplace_back(t.c_str());
+  }
+  MultiTactic t(names.empty() ? default_tactics : names);
+  auto s = t.mkSolver();
+  Z3_solver_set_params(ctx(), s, p);
+  Z3_params_dec_ref(ctx(), p);
+
+  auto fmls = Z3_parse_smtlib2_string(ctx(), query.c_str(), 0, nullptr,
+                                      nullptr, 0, nullptr, nullptr);
+  Z3_ast_vector_inc_ref(ctx(), fmls);
+  for (unsigned i = 0, e = Z3_ast_vector_size(ctx(), fmls); i != e; ++i) {
+    Z3_solver_assert(ctx(), s, Z3_ast_vector_get(ctx(), fmls, i));
+  }
+  Z3_ast_vector_dec_ref(ctx(), fmls);
+
+  string result;
+  bool memout;
+  switch (check_memory_governed(s, memout)) {
+  case Z3_L_FALSE: result = "unsat"; break;
+  case Z3_L_TRUE:  result = "sat"; break;
+  case Z3_L_UNDEF:
+    result = memout ? "memout" : Z3_solver_get_reason_unknown(ctx(), s);
+    break;
+  }
+  Z3_solver_dec_ref(ctx(), s);
+  return result;
+}
+
 void solver_init() {
-  tactic.emplace({
-    "simplify",
-    "propagate-values",
-    "simplify",
-    "elim-uncnstr",
-    "qe-light",
-    "simplify",
-    "elim-uncnstr",
-    "reduce-args",
-    "qe-light",
-    "simplify",
-    "smt"
-  });
+  tactic.emplace(default_tactics);
 }
 
 void solver_destroy() {
   tactic.reset();
+  tactic_qf.reset();
+  tactic_qf_bv.reset();
+  tactic_qf_fp.reset();
 }
 
 }
@@ -5,9 +5,11 @@
 
 #include "smt/expr.h"
 #include <cassert>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 typedef struct _Z3_func_interp *Z3_func_interp;
 typedef struct _Z3_model* Z3_model;
@@ -84,7 +86,7 @@ public:
 
 class Result {
 public:
-  enum answer { UNSAT, SAT, INVALID, SKIP, TIMEOUT, ERROR };
+  enum answer { UNSAT, SAT, INVALID, SKIP, TIMEOUT, MEMOUT, ERROR };
 
   Result() : a(ERROR) {}
 
@@ -103,6 +105,10 @@ public:
   bool isTimeout() const {
     return a == TIMEOUT;
   }
+  // Z3 used more than the memory limit (see solver_memory_governor)
+  bool isMemout() const {
+    return a == MEMOUT;
+  }
   bool isError() const {
     return a == ERROR;
   }
@@ -126,10 +132,12 @@ private:
   Result(Z3_model m) : m(m), a(SAT) {}
 
   friend class Solver;
+  friend class ParallelCheck;
 };
 
 class Solver {
   Z3_solver s;
+  bool simple;
   bool valid = true;
   bool is_unsat = false;
 
@@ -147,6 +155,7 @@ public:
   Result check() const;
 
   friend class SolverPush;
+  friend class ParallelCheck;
 };
 
 Result check_expr(const expr &e);
@@ -159,10 +168,99 @@ public:
   ~SolverPush();
 };
 
+// Checks each formula together with the assertions of the solver in its own
+// forked process. The processes send back what they added to the query
+// statistics, which are merged into this process's. Results are meant to be
+// taken in order, stopping at the first SAT one, so once a formula is SAT the
+// processes of the formulas after it are killed. The rest are killed on
+// destruction.
+class ParallelCheck {
+  Solver &s;
+  const std::vector<expr> &fmls;
+  const std::vector<const char*> &kinds;
+  std::vector<int> pids; // -1 once the process is gone
+  std::vector<int> fds;
+  // the answer of each process followed by the reason for an error or the
+  // model of a SAT answer; empty if the process didn't report one
+  std::vector<std::string> msgs;
+
+  void receive(unsigned i);
+  void kill(unsigned i);
+
+public:
+  // kinds[i] labels the query of fmls[i] (see QueryLabel)
+  ParallelCheck(Solver &s, const std::vector<expr> &fmls,
+                const std::vector<const char*> &kinds);
+  ~ParallelCheck();
+
+  // Waits for the result of the i-th formula. Models can't be sent between
+  // processes as such, so SAT formulas are checked again in this process,
+  // with their variables fixed to the values of the child's model.
+  Result get(unsigned i);
+};
+
+// Labels the queries checked during its lifetime in the telemetry log with
+// the function being verified and the kind of check.
+class QueryLabel {
+  std::string prev_fn;
+  const char *prev_kind;
+public:
+  QueryLabel(const char *kind);
+  QueryLabel(const std::string &fn, const char *kind);
+  ~QueryLabel();
+};
+
 void solver_print_queries(bool yes);
 void solver_tactic_verbose(bool yes);
+// Race each query against n - 1 other solver configurations in forked
+// processes (disabled if n <= 1).
+void solver_portfolio(unsigned n);
+// Pick a tactic pipeline for each query based on the theories it uses.
+void solver_select_tactics(bool yes);
+// Interrupt checks once Z3 uses more than the memory limit (see
+// set_memory_limit); they return MEMOUT. Otherwise, Z3 errors out at its 2GB
+// high watermark.
+void solver_memory_governor(bool yes);
 void solver_print_stats(std::ostream &os);
 
+// Re-solves the queries that timed out and were queued in dir (see
+// config::smt_retry_dir). Each attempt multiplies the query's timeout by 4,
+// up to max_timeout ms, and uses a different random seed. Queries that get a
+// verdict leave the queue, and their verdicts go to the query cache if it's
+// enabled. The others stay in the queue, including those that ran out of
+// memory (see solver_memory_governor), failed, or whose timeout was already
+// the largest. Prints a line per query to os.
+struct RetryStats {
+  unsigned num_solved = 0;    // queries that got a verdict
+  unsigned num_incorrect = 0; // SAT refinement checks among them
+  unsigned num_queued = 0;    // queries left in the queue
+};
+RetryStats solver_retry_queue(const std::string &dir, unsigned max_timeout,
+                              std::ostream &os);
+
+// Solves an SMT-LIB query with a fresh solver built from the given tactic
+// chain (the one used for all queries if empty) and Z3 parameters, given as
+// "name=value", with the given timeout in ms.
+// Returns "sat", "unsat", "memout" (see solver_memory_governor), or Z3's
+// reason for unknown (e.g., "timeout").
+std::string solver_check_smtlib(const std::string &query,
+                                const std::vector<std::string> &tactics,
+                                const std::vector<std::string> &params,
+                                unsigned timeout);
+
+struct SolverStats {
+  unsigned num_queries = 0;
+  float wall_seconds = 0;
+  float cpu_seconds = 0;
+  uint64_t peak_alloc_size = 0; // as estimated by Z3
+  // Wall and CPU time of each query, in the order they were sent
+  std::vector<std::pair<float, float>> query_seconds;
+};
+
+// Statistics of the queries sent to Z3 since the last reset.
+const SolverStats& solver_get_stats();
+void solver_reset_stats();
+
 struct EnableSMTQueriesTMP {
   bool old;
   EnableSMTQueriesTMP();
@@ -4,7 +4,7 @@
 import lit.TestRunner
 import lit.util
 from .base import TestFormat
-import os, re, signal, string, subprocess
+import os, re, shutil, signal, string, subprocess, tempfile
 
 ok_string = 'Transformation seems to be correct!'
 ok_interp = 'functions interpreted successfully'
@@ -69,7 +69,7 @@ class Alive2Test(TestFormat):
            filename.endswith('.ident.ll') or
            filename.endswith('.exec.ll') or 
            (filename.endswith('.ll') and not filename.endswith('.tgt.ll')) or
-           filename.endswith('.yml')):
+           filename.endswith('.yml') or filename.endswith('.smt2')):
         yield lit.Test.Test(testSuite, path_in_suite + (filename,), localConfig)
 
 
@@ -119,9 +119,16 @@ class Alive2Test(TestFormat):
       if not os.path.isfile('alive-worker-test'):
         return lit.Test.UNSUPPORTED, ''
 
+    # a query queued by --smt-retry-dir, retried in a queue of its own
+    smt_retry = test.endswith('.smt2')
+    if smt_retry:
+      cmd = ['./alive-smt-retry']
+      if not os.path.isfile('alive-smt-retry'):
+        return lit.Test.UNSUPPORTED, ''
+
     if not alive_tv_1 and not alive_tv_2 and not alive_tv_3 and \
        not clang_tv and not opt_tv and not alive_exec and not llvm_exec \
-       and not worker_exec:
+       and not worker_exec and not smt_retry:
        #not clang_tv and not opt_tv and not alive_exec and not llvm_exec:
       cmd = ['./alive', '-smt-to:20000']
 
@@ -150,13 +157,20 @@ class Alive2Test(TestFormat):
       except Exception as e:
         return lit.Test.FAIL, e
 
-    cmd.append(test)
+    if smt_retry:
+      queue = tempfile.mkdtemp()
+      shutil.copy(test, queue)
+      cmd.append(queue)
+    else:
+      cmd.append(test)
     if alive_tv_2:
       cmd.append(test.replace('.src.ll', '.tgt.ll'))
     elif alive_tv_3:
       cmd = cmd + [test, '-always-verify']
     out, err, exitCode = executeCommand(cmd)
     output = out + err
+    if smt_retry:
+      shutil.rmtree(queue)
 
     xfail = self.regex_xfail.search(input)
     if xfail != None and output.find(xfail.group(1)) != -1:
@@ -182,7 +196,7 @@ class Alive2Test(TestFormat):
 
     expect_err = self.regex_errs.search(input)
     if expect_err is None and xfail is None and len(chks) == 0 and \
-       chk_not is None and not worker_exec:
+       chk_not is None and not worker_exec and not smt_retry:
       # If there's no other test, correctness of the transformation should be
       # checked.
       if exitCode == 0 and output.find(ok_string) != -1 and \
@@ -0,0 +1,11 @@
+;; alive-retry fn: src
+;; alive-retry kind: value
+;; alive-retry timeout: 1000
+; TEST-ARGS: -max-to=2000
+; CHECK: not retried, timeout 1000ms is already the largest src value
+; CHECK: Solved 0 queries
+; CHECK: Left 1 queries in the queue
+; CHECK-NOT: attempts
+(declare-fun x () (_ BitVec 8))
+(assert (not (= (bvadd x x) (bvshl x #x01))))
+(check-sat)
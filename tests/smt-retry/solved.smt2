@@ -0,0 +1,9 @@
+;; alive-retry fn: src
+;; alive-retry kind: value
+;; alive-retry timeout: 1
+; CHECK: unsat after 1 attempts
+; CHECK: Solved 1 queries
+; CHECK-NOT: Left
+(declare-fun x () (_ BitVec 8))
+(assert (not (= (bvadd x x) (bvshl x #x01))))
+(check-sat)
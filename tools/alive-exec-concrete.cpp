@@ -137,6 +137,11 @@ void execFunction(llvm::Function &F, llvm::TargetLibraryInfoWrapperPass &TLI,
       ++errorCount;
       return;
     }
+    if (r.isMemout()) {
+      cout << "ERROR: SMT solver ran out of memory\n";
+      ++errorCount;
+      return;
+    }
     if (r.isSkip()) {
       cout << "ERROR: SMT queries disabled";
       ++errorCount;
@@ -243,6 +248,8 @@ will attempt to execute every function in the bitcode file.
 
   if (opt_alias_stats)
     IR::Memory::printAliasStats(cout);
+  if (opt_fold_stats)
+    smt::expr_print_fold_stats(cout);
 
   return errorCount > 0;
 }
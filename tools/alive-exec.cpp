@@ -108,6 +108,8 @@ void execFunction(llvm::Function &F, llvm::TargetLibraryInfoWrapperPass &TLI,
       cout << "ERROR: Error in SMT solver: " << r.getReason() << '\n';
     } else if (r.isTimeout()) {
       cout << "ERROR: SMT solver timedout\n";
+    } else if (r.isMemout()) {
+      cout << "ERROR: SMT solver ran out of memory\n";
     } else if (r.isSkip()) {
       cout << "ERROR: SMT queries disabled";
     } else {
@@ -270,6 +272,8 @@ will attempt to execute every function in the bitcode file.
 
   if (opt_alias_stats)
     IR::Memory::printAliasStats(cout);
+  if (opt_fold_stats)
+    smt::expr_print_fold_stats(cout);
 
   return errorCount > 0;
 }
@@ -0,0 +1,357 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+// alive-smt-replay re-solves SMT queries dumped with --smt-bench under one or
+// more solver configurations, using a pool of processes, and compares the
+// results and solve times of the configurations. A configuration is given as
+//   NAME[:ITEM,ITEM,...]
+// where each ITEM is either tactics=T1+T2+... to replace the tactic chain
+// used by Alive2, or a Z3 parameter as name=value. For example:
+//   alive-smt-replay bench/ --config=base --config=seed1:random_seed=1
+//     --config=qfbv:tactics=simplify+qfbv
+
+#include "smt/smt.h"
+#include "smt/solver.h"
+#include "util/bench_archive.h"
+#include "util/stopwatch.h"
+#include "util/version.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace util;
+using namespace std;
+namespace fs = std::filesystem;
+
+static llvm::cl::OptionCategory alive_cmdargs("Alive2 smt-replay options");
+
+static llvm::cl::list<string> opt_inputs(llvm::cl::Positional,
+  llvm::cl::OneOrMore,
+  llvm::cl::desc("<--smt-bench archives, .smt2 files or directories>"),
+  llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::list<string> opt_configs("config",
+  llvm::cl::desc("Solver configuration NAME[:tactics=T1+T2...,param=value...]"
+                 " (default: the one Alive2 uses)"),
+  llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_jobs("jobs",
+  llvm::cl::desc("Number of processes (default=number of CPUs)"),
+  llvm::cl::init(thread::hardware_concurrency()),
+  llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_smt_to("smt-to",
+  llvm::cl::desc("Timeout for each query in ms (default=10000)"),
+  llvm::cl::init(10000), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_smt_random_seed("smt-random-seed",
+  llvm::cl::desc("Random seed for the SMT solver (default=0)"),
+  llvm::cl::init(0), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_smt_max_mem("smt-max-mem",
+  llvm::cl::desc("Interrupt queries that use more than this memory (approx) "
+                 "per process in MB"),
+  llvm::cl::init(1024), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<string> opt_csv("csv",
+  llvm::cl::desc("Write the result and time of each query and configuration "
+                 "to this file"),
+  llvm::cl::value_desc("filename"), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_top("top",
+  llvm::cl::desc("Number of largest time differences to list (default=10)"),
+  llvm::cl::init(10), llvm::cl::cat(alive_cmdargs));
+
+namespace {
+
+struct Config {
+  string name;
+  vector<string> tactics;
+  vector<string> params;
+};
+
+struct Query {
+  string name;
+  unsigned hits;
+  string text;
+};
+
+enum Verdict : int32_t {
+  NOT_RUN, RUNNING, UNSAT, SAT, TIMEOUT, MEMOUT, OTHER, NUM_VERDICTS
+};
+
+const char *verdict_names[] = {
+  "not run", "crash", "unsat", "sat", "timeout", "memout", "other"
+};
+
+// Shared by the worker processes
+struct Outcome {
+  atomic<int32_t> verdict;
+  float seconds;
+};
+
+}
+
+static Config parse_config(const string &spec) {
+  Config c;
+  auto colon = spec.find(':');
+  c.name = spec.substr(0, colon);
+  if (colon == string::npos)
+    return c;
+
+  string_view items(spec);
+  items.remove_prefix(colon + 1);
+  while (!items.empty()) {
+    auto comma = items.find(',');
+    string item(items.substr(0, comma));
+    items.remove_prefix(comma == string_view::npos ? items.size() : comma + 1);
+
+    if (item.starts_with("tactics=")) {
+      string_view ts(item);
+      ts.remove_prefix(8);
+      while (!ts.empty()) {
+        auto plus = ts.find('+');
+        c.tactics.emplace_back(ts.substr(0, plus));
+        ts.remove_prefix(plus == string_view::npos ? ts.size() : plus + 1);
+      }
+    } else if (!item.empty()) {
+      c.params.emplace_back(std::move(item));
+    }
+  }
+  return c;
+}
+
+static void load_queries(const string &input, vector<Query> &queries) {
+  auto add_file = [&](const fs::path &path) {
+    ifstream file(path);
+    string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    queries.push_back({ path.filename().string(), 1, std::move(text) });
+  };
+
+  if (fs::is_regular_file(fs::path(input) / "index")) {
+    for (auto &q : BenchArchive::read(input)) {
+      queries.push_back({ q.hash + " (" + q.location + ')', q.hits,
+                          std::move(q.text) });
+    }
+  } else if (fs::is_directory(input)) {
+    vector<fs::path> files;
+    for (auto &entry : fs::directory_iterator(input)) {
+      if (entry.path().extension() == ".smt2")
+        files.emplace_back(entry.path());
+    }
+    sort(files.begin(), files.end());
+    for (auto &path : files) {
+      add_file(path);
+    }
+  } else {
+    add_file(input);
+  }
+}
+
+static void run_worker(const vector<Query> &queries,
+                       const vector<Config> &configs, atomic<unsigned> &next,
+                       Outcome *outcomes) {
+  unsigned num_jobs = queries.size() * configs.size();
+  for (unsigned job; (job = next++) < num_jobs; ) {
+    auto &q = queries[job / configs.size()];
+    auto &c = configs[job % configs.size()];
+    auto &out = outcomes[job];
+    out.verdict = RUNNING;
+
+    StopWatch sw;
+    auto r = smt::solver_check_smtlib(q.text, c.tactics, c.params, opt_smt_to);
+    sw.stop();
+
+    out.seconds = sw.seconds();
+    out.verdict = r == "unsat" ? UNSAT :
+                  r == "sat" ? SAT :
+                  r == "timeout" ? TIMEOUT :
+                  r == "memout" ? MEMOUT : OTHER;
+  }
+}
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::PrettyStackTraceProgram X(argc, argv);
+
+  llvm::cl::HideUnrelatedOptions(alive_cmdargs);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "Alive2 SMT query replayer version " +
+                                    string(alive_version) + "\n");
+
+  vector<Config> configs;
+  for (auto &spec : opt_configs) {
+    configs.emplace_back(parse_config(spec));
+  }
+  if (configs.empty())
+    configs.push_back({ "default", {}, {} });
+
+  vector<Query> queries;
+  for (auto &input : opt_inputs) {
+    load_queries(input, queries);
+  }
+  if (queries.empty()) {
+    cerr << "No queries found\n";
+    return 1;
+  }
+
+  smt::set_random_seed(to_string(opt_smt_random_seed));
+  smt::set_memory_limit((uint64_t)opt_smt_max_mem * 1024 * 1024);
+  smt::solver_memory_governor(opt_smt_max_mem.getNumOccurrences() > 0);
+  smt::smt_initializer smt_init;
+
+  // Z3 aborts on unknown tactics and parameters, so try the configurations
+  // before starting the workers
+  for (auto &c : configs) {
+    smt::solver_check_smtlib("", c.tactics, c.params, opt_smt_to);
+  }
+
+  unsigned num_jobs = queries.size() * configs.size();
+  size_t shared_size = sizeof(atomic<unsigned>) + num_jobs * sizeof(Outcome);
+  void *shared = mmap(nullptr, shared_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    cerr << "Couldn't allocate shared memory\n";
+    return 1;
+  }
+  auto &next = *new (shared) atomic<unsigned>(0);
+  auto *outcomes = (Outcome*)((char*)shared + sizeof(atomic<unsigned>));
+  for (unsigned i = 0; i < num_jobs; ++i) {
+    new (&outcomes[i]) Outcome{ { NOT_RUN }, 0 };
+  }
+
+  cout << "Replaying " << queries.size() << " queries with " << configs.size()
+       << " configurations on " << opt_jobs << " processes\n";
+  StopWatch wall;
+
+  // Workers that crash (e.g., Z3 running out of memory) are replaced while
+  // there are jobs left; their query is reported as a crash.
+  auto fork_worker = [&]() {
+    pid_t pid = fork();
+    if (pid == 0) {
+      run_worker(queries, configs, next, outcomes);
+      _exit(0);
+    }
+    return pid;
+  };
+  unsigned running = 0;
+  for (unsigned i = 0; i < max(1u, unsigned(opt_jobs)); ++i) {
+    if (fork_worker() > 0)
+      ++running;
+  }
+  while (running > 0) {
+    int status;
+    if (wait(&status) == -1)
+      break;
+    --running;
+    if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0) &&
+        next < num_jobs && fork_worker() > 0)
+      ++running;
+  }
+  wall.stop();
+
+  if (!opt_csv.empty()) {
+    ofstream csv(opt_csv);
+    csv << "query,hits,config,result,seconds\n";
+    for (unsigned job = 0; job < num_jobs; ++job) {
+      auto &q = queries[job / configs.size()];
+      auto &c = configs[job % configs.size()];
+      csv << '"' << q.name << "\"," << q.hits << ",\"" << c.name << "\","
+          << verdict_names[outcomes[job].verdict] << ','
+          << outcomes[job].seconds << '\n';
+    }
+  }
+
+  cout << fixed << setprecision(2) << '\n' << left << setw(16)
+       << "configuration" << right;
+  for (unsigned v = UNSAT; v < NUM_VERDICTS; ++v) {
+    cout << setw(9) << verdict_names[v];
+  }
+  cout << setw(9) << "crash" << setw(12) << "time(s)" << setw(16)
+       << "weighted(s)" << '\n';
+
+  for (unsigned ci = 0; ci < configs.size(); ++ci) {
+    unsigned counts[NUM_VERDICTS] = {};
+    double time = 0, weighted = 0;
+    for (unsigned qi = 0; qi < queries.size(); ++qi) {
+      auto &out = outcomes[qi * configs.size() + ci];
+      ++counts[out.verdict];
+      time += out.seconds;
+      weighted += out.seconds * queries[qi].hits;
+    }
+    cout << left << setw(16) << configs[ci].name.substr(0, 15) << right;
+    for (unsigned v = UNSAT; v < NUM_VERDICTS; ++v) {
+      cout << setw(9) << counts[v];
+    }
+    cout << setw(9) << counts[RUNNING] << setw(12) << time << setw(16)
+         << weighted << '\n';
+  }
+  cout << "(weighted: times multiplied by the number of times each query was "
+          "seen)\n";
+
+  // sat vs unsat is a solver bug
+  bool header = false;
+  for (unsigned qi = 0; qi < queries.size(); ++qi) {
+    bool sat = false, unsat = false;
+    for (unsigned ci = 0; ci < configs.size(); ++ci) {
+      auto v = outcomes[qi * configs.size() + ci].verdict.load();
+      sat |= v == SAT;
+      unsat |= v == UNSAT;
+    }
+    if (!sat || !unsat)
+      continue;
+    if (!header)
+      cout << "\nConflicting results:\n";
+    header = true;
+    cout << "  " << queries[qi].name << ':';
+    for (unsigned ci = 0; ci < configs.size(); ++ci) {
+      cout << ' ' << configs[ci].name << '='
+           << verdict_names[outcomes[qi * configs.size() + ci].verdict];
+    }
+    cout << '\n';
+  }
+
+  for (unsigned ci = 1; ci < configs.size() && opt_top > 0; ++ci) {
+    vector<pair<float, unsigned>> diffs;
+    for (unsigned qi = 0; qi < queries.size(); ++qi) {
+      auto base = outcomes[qi * configs.size()].seconds;
+      auto t = outcomes[qi * configs.size() + ci].seconds;
+      diffs.emplace_back(t - base, qi);
+    }
+    sort(diffs.begin(), diffs.end(), [](auto &a, auto &b) {
+      return abs(a.first) > abs(b.first);
+    });
+    cout << "\nLargest differences of " << configs[ci].name << " vs "
+         << configs[0].name << " (s):\n";
+    for (unsigned i = 0; i < diffs.size() && i < opt_top; ++i) {
+      auto qi = diffs[i].second;
+      auto &base = outcomes[qi * configs.size()];
+      auto &out = outcomes[qi * configs.size() + ci];
+      cout << "  " << showpos << setw(9) << diffs[i].first << noshowpos
+           << "  " << setw(8) << base.seconds << ' ' << setw(8)
+           << verdict_names[base.verdict] << setw(9) << out.seconds << ' '
+           << setw(8) << verdict_names[out.verdict] << "  "
+           << queries[qi].name << '\n';
+    }
+  }
+
+  cout << "\nWall time: " << wall.seconds() << "s\n";
+  munmap(shared, shared_size);
+  return 0;
+}
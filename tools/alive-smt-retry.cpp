@@ -0,0 +1,74 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+// alive-smt-retry re-solves the SMT queries that timed out during earlier
+// runs of alive-tv or the tv plugin with --smt-retry-dir, using larger
+// timeouts. With --smt-cache pointing at the cache of those runs, the
+// verdicts it finds are used by the next runs right away.
+
+#include "smt/smt.h"
+#include "smt/solver.h"
+#include "util/config.h"
+#include "util/version.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+
+#include <iostream>
+#include <string>
+
+using namespace util;
+using namespace std;
+
+static llvm::cl::OptionCategory alive_cmdargs("Alive2 smt-retry options");
+
+static llvm::cl::opt<string> opt_dir(llvm::cl::Positional, llvm::cl::Required,
+  llvm::cl::desc("<queue directory>"), llvm::cl::value_desc("directory"),
+  llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_max_to("max-to",
+  llvm::cl::desc("Largest timeout to try, in ms (default=600000)"),
+  llvm::cl::init(600000), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_smt_random_seed("smt-random-seed",
+  llvm::cl::desc("Base random seed for the SMT solver (default=0)"),
+  llvm::cl::init(0), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_smt_max_mem("smt-max-mem",
+  llvm::cl::desc("Interrupt queries that use more than this memory (approx) "
+                 "in MB"),
+  llvm::cl::init(1024), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<string> opt_smt_cache_dir("smt-cache",
+  llvm::cl::desc("Record the verdicts in this SMT query cache"),
+  llvm::cl::value_desc("directory"), llvm::cl::cat(alive_cmdargs));
+
+static llvm::cl::opt<unsigned> opt_smt_cache_size("smt-cache-size",
+  llvm::cl::desc("Maximum size of the SMT query cache in MB (default=1024)"),
+  llvm::cl::init(1024), llvm::cl::cat(alive_cmdargs));
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::PrettyStackTraceProgram X(argc, argv);
+
+  llvm::cl::HideUnrelatedOptions(alive_cmdargs);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "Alive2 SMT query retrier version " +
+                                    string(alive_version) + "\n");
+
+  smt::set_random_seed(to_string(opt_smt_random_seed));
+  smt::set_memory_limit((uint64_t)opt_smt_max_mem * 1024 * 1024);
+  smt::solver_memory_governor(opt_smt_max_mem.getNumOccurrences() > 0);
+  config::smt_cache_dir = opt_smt_cache_dir;
+  config::smt_cache_max_size = (uint64_t)opt_smt_cache_size * 1024 * 1024;
+
+  smt::smt_initializer smt_init;
+  auto retry = smt::solver_retry_queue(opt_dir, opt_max_to, cout);
+  cout << "Solved " << retry.num_solved << " queries\n";
+  if (retry.num_queued)
+    cout << "Left " << retry.num_queued << " queries in the queue\n";
+  if (retry.num_incorrect)
+    cout << "Found " << retry.num_incorrect << " incorrect transformations\n";
+  return retry.num_incorrect > 0;
+}
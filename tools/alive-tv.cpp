@@ -2,6 +2,7 @@
 // Distributed under the MIT license that can be found in the LICENSE file.
 
 #include "llvm_util/llvm2alive.h"
+#include "smt/expr.h"
 #include "smt/smt.h"
 #include "tools/transform.h"
 #include "util/version.h"
@@ -160,6 +161,18 @@ unsigned num_unsound = 0;
 unsigned num_failed = 0;
 unsigned num_errors = 0;
 
+// Re-solves the queries that timed out with larger timeouts. The
+// transformations of the ones found incorrect were counted as failed-to-prove.
+static void retryTimedOutQueries() {
+  if (!opt_smt_retry_to || config::smt_retry_dir.empty())
+    return;
+  *out << "Retrying timed out queries:\n";
+  auto retry = smt::solver_retry_queue(config::smt_retry_dir,
+                                       opt_smt_retry_to, *out);
+  num_unsound += retry.num_incorrect;
+  num_failed -= min(num_failed, retry.num_incorrect);
+}
+
 bool compareFunctions(llvm::Function &F1, llvm::Function &F2,
                       llvm::TargetLibraryInfoWrapperPass &TLI) {
   auto r = verify(F1, F2, TLI, !opt_quiet, opt_always_verify);
@@ -327,6 +340,7 @@ convenient way to demonstrate an existing optimizer bug.
     auto TGT = findFunction(*M1, opt_tgt_fn);
     if (SRC && TGT) {
       compareFunctions(*SRC, *TGT, TLI);
+      retryTimedOutQueries();
       goto end;
     } else {
       M2 = CloneModule(*M1);
@@ -362,6 +376,8 @@ convenient way to demonstrate an existing optimizer bug.
     }
   }
 
+  retryTimedOutQueries();
+
   *out << "Summary:\n"
           "  " << num_correct << " correct transformations\n"
           "  " << num_unsound << " incorrect transformations\n"
@@ -376,6 +392,8 @@ end:
 
   if (opt_alias_stats)
     IR::Memory::printAliasStats(*out);
+  if (opt_fold_stats)
+    smt::expr_print_fold_stats(*out);
 
   return num_errors > 0;
 }
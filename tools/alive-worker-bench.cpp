@@ -0,0 +1,404 @@
+// Copyright (c) 2021-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+// alive-worker-bench measures the throughput of alive-worker without a real
+// memodb-server. It serves the jobs from worker test files (like those in
+// tests/worker-tv and tests/worker-interpret) using a minimal in-process
+// implementation of the memodb API that alive-worker uses:
+//
+// - POST /cid and GET /cid/... store and load nodes.
+// - POST /worker hands out the next job, or null if there are none left.
+// - PUT /call/... receives the result of a job.
+//
+// It starts alive-worker against this server, waits until every job has a
+// result, and reports jobs/sec, the latency from claiming a job to receiving
+// its result, and the per-phase times from the "stats" of the results.
+
+#include "util/version.h"
+#include "util/worker_yaml.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <httplib.h>
+#include <jsoncons/byte_string.hpp>
+#include <jsoncons/json.hpp>
+#include <jsoncons_ext/cbor/decode_cbor.hpp>
+#include <jsoncons_ext/cbor/encode_cbor.hpp>
+
+using namespace util;
+using namespace std;
+using jsoncons::byte_string_arg;
+using jsoncons::encode_base64url;
+using jsoncons::json_object_arg;
+using jsoncons::ojson;
+using jsoncons::cbor::decode_cbor;
+using jsoncons::cbor::encode_cbor;
+using Clock = std::chrono::steady_clock;
+
+static llvm::cl::OptionCategory alive_cmdargs("Alive2 worker-bench options");
+static llvm::cl::list<string> test_filenames(llvm::cl::Positional,
+                                             llvm::cl::OneOrMore,
+                                             llvm::cl::desc("<test files>"),
+                                             llvm::cl::value_desc("filename"),
+                                             llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<string>
+    opt_worker("worker",
+               llvm::cl::desc("alive-worker binary to run (default: the one "
+                              "next to this program)"),
+               llvm::cl::value_desc("filename"), llvm::cl::cat(alive_cmdargs));
+static llvm::cl::list<string>
+    opt_worker_args("worker-arg",
+                    llvm::cl::desc("Extra argument to pass to alive-worker"),
+                    llvm::cl::value_desc("argument"),
+                    llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<unsigned>
+    opt_repeat("repeat",
+               llvm::cl::desc("Number of times to submit each job "
+                              "(default=1)"),
+               llvm::cl::init(1), llvm::cl::cat(alive_cmdargs));
+
+namespace {
+// The subset of memodb-server that alive-worker needs.
+class Server {
+  httplib::Server http;
+  mutex m;
+  condition_variable cv;
+  map<string, string> nodes;                   // text CID -> CBOR
+  map<string, ojson> cids;                     // CBOR -> CID
+  deque<pair<ojson, string>> queue;            // job, call URI
+  multimap<string, Clock::time_point> claimed; // call URI -> claim time
+
+  void handlePostCID(const httplib::Request &req, httplib::Response &res);
+  void handleGetCID(const httplib::Request &req, httplib::Response &res);
+  void handlePostWorker(const httplib::Request &req, httplib::Response &res);
+  void handlePutCall(const httplib::Request &req, httplib::Response &res);
+
+public:
+  vector<double> latencies; // in seconds
+  vector<ojson> results;
+
+  Server();
+  ojson putNode(const ojson &node);
+  void addJob(const string &func, const ojson &args);
+  int listen();
+  void stop();
+  // Waits until there are num results or the timeout expires, and returns
+  // the number of results.
+  size_t waitForResults(size_t num, chrono::milliseconds timeout);
+};
+} // end anonymous namespace
+
+static string binaryCIDToText(const ojson &cid) {
+  string text = "u";
+  auto bytes = cid.as_byte_string_view();
+  encode_base64url(bytes.begin() + 1, bytes.end(), text);
+  return text;
+}
+
+Server::Server() {
+  http.Post("/cid", [this](const auto &req, auto &res) {
+    handlePostCID(req, res);
+  });
+  http.Get(R"(/cid/(u[\w-]+))", [this](const auto &req, auto &res) {
+    handleGetCID(req, res);
+  });
+  http.Post("/worker", [this](const auto &req, auto &res) {
+    handlePostWorker(req, res);
+  });
+  http.Put(R"(/call/.+)", [this](const auto &req, auto &res) {
+    handlePutCall(req, res);
+  });
+}
+
+ojson Server::putNode(const ojson &node) {
+  string buffer;
+  encode_cbor(node, buffer);
+  lock_guard lock(m);
+  auto [it, inserted] = cids.try_emplace(buffer);
+  if (inserted) {
+    // Real CIDs are hashes, but any unique bytes will do for alive-worker.
+    vector<uint8_t> cid{0x00, 0x01, 0x71, 0x00, 0x08};
+    uint64_t id = nodes.size();
+    for (unsigned i = 0; i < 8; ++i)
+      cid.push_back(uint8_t(id >> (8 * i)));
+    it->second = ojson(byte_string_arg, cid, 42);
+    nodes.emplace(binaryCIDToText(it->second), std::move(buffer));
+  }
+  return it->second;
+}
+
+void Server::addJob(const string &func, const ojson &args) {
+  ojson job(json_object_arg);
+  job["func"] = func;
+  job["args"] = ojson(jsoncons::json_array_arg);
+  string call_uri = "/call/" + func + "/";
+  for (const auto &arg : args.array_range()) {
+    auto cid = putNode(arg);
+    call_uri += binaryCIDToText(cid) + ",";
+    job["args"].push_back(std::move(cid));
+  }
+  call_uri.pop_back(); // remove last comma
+  lock_guard lock(m);
+  queue.emplace_back(std::move(job), std::move(call_uri));
+}
+
+void Server::handlePostCID(const httplib::Request &req,
+                           httplib::Response &res) {
+  auto cid = putNode(decode_cbor<ojson>(req.body));
+  res.status = 201;
+  res.set_header("Location", "/cid/" + binaryCIDToText(cid));
+}
+
+void Server::handleGetCID(const httplib::Request &req,
+                          httplib::Response &res) {
+  lock_guard lock(m);
+  auto it = nodes.find(req.matches[1]);
+  if (it == nodes.end()) {
+    res.status = 404;
+    return;
+  }
+  res.set_content(it->second, "application/cbor");
+}
+
+void Server::handlePostWorker(const httplib::Request &req,
+                              httplib::Response &res) {
+  string buffer;
+  unique_lock lock(m);
+  if (queue.empty()) {
+    encode_cbor(ojson::null(), buffer);
+  } else {
+    auto [job, call_uri] = std::move(queue.front());
+    queue.pop_front();
+    claimed.emplace(std::move(call_uri), Clock::now());
+    encode_cbor(job, buffer);
+  }
+  lock.unlock();
+  res.set_content(buffer, "application/cbor");
+}
+
+void Server::handlePutCall(const httplib::Request &req,
+                           httplib::Response &res) {
+  auto now = Clock::now();
+  auto cid = decode_cbor<ojson>(req.body);
+  lock_guard lock(m);
+  auto node = nodes.find(binaryCIDToText(cid));
+  auto claim = claimed.find(req.path);
+  if (node == nodes.end() || claim == claimed.end()) {
+    res.status = 400;
+    return;
+  }
+  latencies.push_back(
+      chrono::duration<double>(now - claim->second).count());
+  claimed.erase(claim);
+  results.push_back(decode_cbor<ojson>(node->second));
+  cv.notify_all();
+}
+
+int Server::listen() {
+  int port = http.bind_to_any_port("127.0.0.1");
+  if (port > 0)
+    thread([this] { http.listen_after_bind(); }).detach();
+  return port;
+}
+
+void Server::stop() {
+  http.stop();
+}
+
+size_t Server::waitForResults(size_t num, chrono::milliseconds timeout) {
+  unique_lock lock(m);
+  cv.wait_for(lock, timeout, [&] { return results.size() >= num; });
+  return results.size();
+}
+
+static pid_t startWorker(const string &url) {
+  string worker = opt_worker;
+  if (worker.empty()) {
+    string self = llvm::sys::fs::getMainExecutable(
+        nullptr, reinterpret_cast<void *>(&startWorker));
+    llvm::SmallString<256> path(llvm::sys::path::parent_path(self));
+    llvm::sys::path::append(path, "alive-worker");
+    worker = string(path);
+  }
+
+  vector<string> args{worker};
+  args.insert(args.end(), opt_worker_args.begin(), opt_worker_args.end());
+  args.push_back(url);
+  vector<char *> argv;
+  for (auto &arg : args)
+    argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // Put the worker and any processes it forks in their own group, so we
+    // can stop them all at once.
+    setpgid(0, 0);
+    // Keep our stdout for the report.
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    execv(argv[0], argv.data());
+    perror("execv");
+    _exit(127);
+  }
+  if (pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  setpgid(pid, pid);
+  return pid;
+}
+
+static double percentile(vector<double> &values, double p) {
+  if (values.empty())
+    return 0;
+  sort(values.begin(), values.end());
+  size_t i = min(values.size() - 1, size_t(p / 100 * values.size()));
+  return values[i];
+}
+
+static void printReport(Server &server, double seconds) {
+  size_t num = server.results.size();
+  map<string, pair<double, double>> phases; // name -> (wall, cpu)
+  uint64_t num_queries = 0, num_cached = 0;
+  for (const auto &result : server.results) {
+    num_cached += result.get_with_default("cached", false);
+    if (!result.contains("stats"))
+      continue;
+    for (const auto &item : result["stats"].object_range()) {
+      const auto &val = item.value();
+      if (val.is_object() && val.contains("wall")) {
+        auto &[wall, cpu] = phases[string(item.key())];
+        wall += val["wall"].as<double>();
+        cpu += val["cpu"].as<double>();
+      }
+    }
+    num_queries +=
+        result["stats"].get_with_default<uint64_t>("num_queries", uint64_t(0));
+  }
+
+  auto &out = llvm::outs();
+  out << "jobs:          " << num << '\n';
+  out << "time:          " << llvm::format("%.3f s", seconds) << '\n';
+  out << "throughput:    " << llvm::format("%.2f jobs/s", num / seconds)
+      << '\n';
+  out << "latency p50:   "
+      << llvm::format("%.1f ms", percentile(server.latencies, 50) * 1000)
+      << '\n';
+  out << "latency p99:   "
+      << llvm::format("%.1f ms", percentile(server.latencies, 99) * 1000)
+      << '\n';
+  out << "SMT queries:   " << num_queries << '\n';
+  if (num_cached)
+    out << "cached:        " << num_cached << " jobs\n";
+  out << "\nper-job time by phase (wall / CPU):\n";
+  for (auto &[name, times] : phases) {
+    out << "  " << llvm::left_justify(name, 12)
+        << llvm::format("%8.2f ms / %8.2f ms", times.first / num * 1000,
+                        times.second / num * 1000)
+        << '\n';
+  }
+}
+
+int main(int argc, char **argv) {
+  llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
+  llvm::PrettyStackTraceProgram X(argc, argv);
+  llvm::EnableDebugBuffering = true;
+  llvm::llvm_shutdown_obj llvm_shutdown; // Call llvm_shutdown() on exit.
+
+  std::string Usage =
+      R"EOF(Alive2 worker benchmark:
+version )EOF";
+  Usage += alive_version;
+  Usage += R"EOF(
+see alive-worker-bench --version  for LLVM version info,
+
+This program runs alive-worker on the jobs in the given test files, using a
+built-in stand-in for memodb-server, and reports its throughput.
+
+Example: alive-worker-bench --worker-arg=--jobs=4 tests/worker-*/*.yml
+)EOF";
+
+  llvm::cl::HideUnrelatedOptions(alive_cmdargs);
+  llvm::cl::ParseCommandLineOptions(argc, argv, Usage);
+
+  Server server;
+  size_t num_jobs = 0;
+  for (const auto &filename : test_filenames) {
+    auto buf_or_err = llvm::MemoryBuffer::getFile(filename);
+    if (!buf_or_err) {
+      cerr << "could not read " << filename << '\n';
+      return 1;
+    }
+    llvm::SourceMgr source_mgr;
+    llvm::yaml::Stream stream((*buf_or_err)->getBuffer(), source_mgr);
+    for (auto &document : stream) {
+      ojson job = yaml2json(*document.getRoot());
+      for (unsigned i = 0; i < opt_repeat; ++i) {
+        // Make each copy a distinct call, as memodb would not run the same
+        // call twice.
+        ojson args = job["args"];
+        if (i)
+          args[0]["bench_copy"] = i;
+        server.addJob(job["func"].as<string>(), args);
+        ++num_jobs;
+      }
+    }
+  }
+
+  int port = server.listen();
+  if (port <= 0) {
+    cerr << "could not start the server\n";
+    return 1;
+  }
+
+  auto start = Clock::now();
+  pid_t worker = startWorker("http://127.0.0.1:" + to_string(port));
+  bool worker_died = false;
+  while (server.waitForResults(num_jobs, chrono::seconds(1)) < num_jobs) {
+    if (waitpid(worker, nullptr, WNOHANG) == worker) {
+      worker_died = true;
+      break;
+    }
+  }
+  double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+  kill(-worker, SIGKILL);
+  if (!worker_died)
+    waitpid(worker, nullptr, 0);
+  server.stop();
+
+  if (worker_died) {
+    cerr << "alive-worker exited after " << server.results.size() << " of "
+         << num_jobs << " jobs; use --worker-arg=--jobs=N to restart it "
+         << "after crashes\n";
+    return 1;
+  }
+
+  printReport(server, seconds);
+  return 0;
+}
@@ -16,24 +16,39 @@
 //
 // Here's a suggested way to run this program:
 //
-//   yes | parallel -n0 alive-worker http://127.0.0.1:1234
+//   alive-worker --jobs=$(nproc) http://127.0.0.1:1234
 //
-// This command will run one alive-worker process per core. Whenever a process
-// exits, it will start a new one to replace it.
+// With --jobs=N, a supervisor process initializes LLVM and Z3 and uploads the
+// worker info once, and then forks N worker processes from that state.
+// Whenever a worker exits (because of a crash or a timeout), the supervisor
+// forks a new one to replace it, so the initialization isn't repeated.
+//
+// With --prefetch, each worker claims and downloads its next job, and uploads
+// the previous result, while it evaluates the current job. If the current job
+// crashes or times out, the prefetched job is claimed but will never be
+// evaluated, so an error result is sent for it as well.
 
+#include "util/disk_cache.h"
 #include "util/version.h"
 #include "util/worker.h"
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <condition_variable>
+#include <ctime>
+#include <deque>
 #include <iostream>
 #include <mutex>
 #include <optional>
+#include <random>
 #include <string>
 #include <thread>
 #include <utility>
@@ -41,6 +56,7 @@
 
 #include <semaphore.h>
 #include <signal.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 // The server may wait 60 seconds to respond if there are no jobs available yet.
@@ -68,9 +84,56 @@ static llvm::cl::opt<string> opt_url(llvm::cl::Positional, llvm::cl::Required,
                                      llvm::cl::desc("<memodb server URL>"),
                                      llvm::cl::value_desc("url"),
                                      llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<unsigned>
+    opt_jobs("jobs",
+             llvm::cl::desc("Number of worker processes to run under a "
+                            "supervisor (default=0: run a single worker in "
+                            "this process)"),
+             llvm::cl::init(0), llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<bool> opt_prefetch(
+    "prefetch",
+    llvm::cl::desc("Claim and download the next job, and upload results, in "
+                   "the background while evaluating a job"),
+    llvm::cl::init(false), llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<string> opt_cache_dir(
+    "cache-dir",
+    llvm::cl::desc("Cache nodes downloaded from and uploaded to the server in "
+                   "this directory, which may be shared by the workers of a "
+                   "server"),
+    llvm::cl::value_desc("directory"), llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<unsigned>
+    opt_cache_size("cache-size",
+                   llvm::cl::desc("Maximum size of the node cache "
+                                  "(default=1024)"),
+                   llvm::cl::value_desc("MB"), llvm::cl::init(1024),
+                   llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<string> opt_result_cache_dir(
+    "result-cache-dir",
+    llvm::cl::desc("Reuse the results of jobs evaluated before, stored in "
+                   "this directory"),
+    llvm::cl::value_desc("directory"), llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<unsigned>
+    opt_result_cache_size("result-cache-size",
+                          llvm::cl::desc("Maximum size of the result cache "
+                                         "(default=256)"),
+                          llvm::cl::value_desc("MB"), llvm::cl::init(256),
+                          llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<unsigned> opt_poll_min_delay(
+    "poll-min-delay",
+    llvm::cl::desc("Delay before polling again after the server had no jobs "
+                   "(default=100)"),
+    llvm::cl::value_desc("ms"), llvm::cl::init(100),
+    llvm::cl::cat(alive_cmdargs));
+static llvm::cl::opt<unsigned> opt_poll_max_delay(
+    "poll-max-delay",
+    llvm::cl::desc("Maximum delay between polls, which grows exponentially "
+                   "while the server has no jobs (default=30000)"),
+    llvm::cl::value_desc("ms"), llvm::cl::init(30000),
+    llvm::cl::cat(alive_cmdargs));
 
 // Used by signal handler to communicate with crash handler thread.
 static sem_t crash_sem;
+static volatile sig_atomic_t crash_handler_started = 0;
 static volatile sig_atomic_t crash_handler_done = 0;
 
 static std::mutex timeout_mutex;
@@ -82,20 +145,86 @@ static bool timeout_cancelled = false;
 static std::mutex result_mutex;
 // May be empty if no result is in progress.
 static std::string result_uri;
-static std::optional<httplib::Client> session;
+
+// The call URI of the job claimed in the background by prefetchThread() with
+// --prefetch, if any, until it's evaluated. prefetch_pending is set while a
+// claim is requested or in flight. Guarded by prefetch_mutex, like
+// prefetched_job.
+static std::mutex prefetch_mutex;
+static std::condition_variable prefetch_cv;
+static std::string prefetched_uri;
+static bool prefetch_pending = false;
+static bool prefetch_cancelled = false;
+
+// Results waiting to be uploaded by uploadThread(): call URI, result.
+static std::mutex upload_mutex;
+static std::condition_variable upload_cv;
+static std::deque<std::pair<std::string, ojson>> upload_queue;
+static bool upload_busy = false;
+static bool upload_cancelled = false;
+
+// httplib serializes requests on the same client, so each thread gets its own
+// connection. Otherwise a long poll on /worker would hold up result uploads.
+static std::string server_url;
+static thread_local std::optional<httplib::Client> session;
+
+static httplib::Client &getSession() {
+  if (!session)
+    session.emplace(server_url);
+  return *session;
+}
+
+// exit() runs the static destructors, including the SMT context's, so only
+// the main thread may call it. The helper threads exit with _exit(), like
+// timeoutThread() does.
+static std::thread::id main_thread;
+
+[[noreturn]] static void exitWorker(int status) {
+  if (std::this_thread::get_id() == main_thread)
+    std::exit(status);
+  _exit(status);
+}
 
 static const httplib::Headers cbor_headers{{"Accept", "application/cbor"}};
 
+// Maps binary CIDs to encoded nodes, and hashes of encoded nodes to their
+// binary CIDs. The nodes were stored on a server at some point, but maybe not
+// on this one (it may have been reset, or the cache is shared with workers of
+// another server), so only downloads can trust the cache.
+static std::optional<DiskCache> node_cache;
+
+static std::string_view cidToKey(const ojson &cid) {
+  auto bytes = cid.as_byte_string_view();
+  return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+}
+
+static std::string nodeHashKey(std::string_view node) {
+  return hash_cache_key('h', node);
+}
+
+static void cacheNode(std::string_view cid_key, std::string_view node) {
+  node_cache->put(cid_key, node);
+  node_cache->put(nodeHashKey(node), cid_key);
+}
+
+// Results of previous jobs. Each entry is keyed by a hash of the job and holds
+// {"job": job, "budget": budget, "result": result}, where job identifies the
+// func, the arguments and the options without the budget (see
+// takeJobBudget()). Results that ran out of budget are kept in separate
+// entries, so they never replace a definitive result. Reused results are
+// returned without their "stats" and with "cached": true.
+static std::optional<DiskCache> result_cache;
+
 static ojson textCIDToBinary(const llvm::StringRef &text) {
   if (!text.startswith("u")) {
     llvm::errs() << "unsupported CID: " << text << "\n";
-    std::exit(1);
+    exitWorker(1);
   }
   std::vector<uint8_t> bytes{0x00};
   auto result = decode_base64url(text.begin() + 1, text.end(), bytes);
   if (result.ec != jsoncons::conv_errc::success) {
     llvm::errs() << "invalid CID: " << text << "\n";
-    std::exit(1);
+    exitWorker(1);
   }
   return ojson(byte_string_arg, bytes, 42);
 }
@@ -105,7 +234,7 @@ static std::string binaryCIDToText(const ojson &cid) {
   auto bytes = cid.as_byte_string_view();
   if (bytes.size() == 0) {
     llvm::errs() << "invalid CID\n";
-    std::exit(1);
+    exitWorker(1);
   }
   encode_base64url(bytes.begin() + 1, bytes.end(), text);
   return text;
@@ -114,53 +243,199 @@ static std::string binaryCIDToText(const ojson &cid) {
 static void checkResult(const httplib::Result &result) {
   if (!result) {
     std::cerr << "HTTP connection error: " << result.error() << '\n';
-    std::exit(1);
+    exitWorker(1);
   }
   if (result->status < 200 || result->status > 299) {
     std::cerr << "HTTP response error: " << result->body << "\n";
-    std::exit(1);
+    exitWorker(1);
   }
 };
 
-static ojson getNodeFromCID(const ojson &cid) {
+namespace {
+// The CBOR encoding of a node, either downloaded or mapped from the node cache.
+struct RawNode {
+  std::string body;
+  MappedFile file;
+
+  std::string_view data() const { return file ? *file : body; }
+};
+} // end anonymous namespace
+
+static RawNode getRawNodeFromCID(const ojson &cid, bool use_cache = true) {
+  RawNode raw;
+  if (node_cache && use_cache) {
+    raw.file = node_cache->get(cidToKey(cid));
+    if (raw.file)
+      return raw;
+  }
+
   std::string uri = "/cid/" + binaryCIDToText(cid);
-  auto result = session->Get(uri.c_str(), cbor_headers);
+  auto result = getSession().Get(uri.c_str(), cbor_headers);
   checkResult(result);
   if (result->get_header_value("Content-Type") != "application/cbor") {
     std::cerr << "unexpected Content-Type!\n";
-    std::exit(1);
+    exitWorker(1);
   }
-  return decode_cbor<ojson>(result->body);
-};
+  if (node_cache)
+    cacheNode(cidToKey(cid), result->body);
+  raw.body = std::move(result->body);
+  return raw;
+}
+
+static ojson decodeNode(const ojson &cid, const RawNode &raw) {
+  try {
+    return decode_cbor<ojson>(raw.data());
+  } catch (const jsoncons::ser_error &) {
+    if (!raw.file)
+      throw;
+    // corrupted cache entry; download the node again
+    return decode_cbor<ojson>(getRawNodeFromCID(cid, false).data());
+  }
+}
+
+// If node is a single definite-length CBOR byte string, as bitcode modules
+// are, returns its contents without decoding them.
+static std::optional<std::string_view>
+getByteStringContents(std::string_view node) {
+  if (node.empty() || uint8_t(node[0]) >> 5 != 2)
+    return {};
+  unsigned info = node[0] & 0x1f;
+  uint64_t size = info;
+  size_t header = 1;
+  if (info >= 28) {
+    return {}; // indefinite length or invalid
+  } else if (info >= 24) {
+    header += size_t(1) << (info - 24);
+    if (node.size() < header)
+      return {};
+    size = 0;
+    for (size_t i = 1; i < header; ++i)
+      size = (size << 8) | uint8_t(node[i]);
+  }
+  if (node.size() - header != size)
+    return {};
+  return node.substr(header);
+}
 
 static ojson putNode(const ojson &node) {
   std::string buffer;
   encode_cbor(node, buffer);
-  auto result = session->Post("/cid", cbor_headers, buffer, "application/cbor");
+
+  // Skip the upload if the server already has this node, which is cheaper to
+  // ask than to upload a large node again.
+  if (node_cache) {
+    if (auto cid_file = node_cache->get(nodeHashKey(buffer))) {
+      auto node_file = node_cache->get(*cid_file);
+      if (node_file && *node_file == buffer) {
+        auto cid_view = *cid_file;
+        ojson cid(byte_string_arg,
+                  std::vector<uint8_t>(cid_view.begin(), cid_view.end()), 42);
+        std::string uri = "/cid/" + binaryCIDToText(cid);
+        auto result = getSession().Head(uri.c_str(), cbor_headers);
+        if (result && result->status == 200)
+          return cid;
+      }
+    }
+  }
+
+  auto result =
+      getSession().Post("/cid", cbor_headers, buffer, "application/cbor");
   checkResult(result);
   string cid_str = result->get_header_value("Location");
   if (!llvm::StringRef(cid_str).startswith("/cid/")) {
     llvm::errs() << "invalid CID URI!\n";
-    std::exit(1);
+    exitWorker(1);
   }
-  return textCIDToBinary(llvm::StringRef(cid_str).drop_front(5));
+  auto cid = textCIDToBinary(llvm::StringRef(cid_str).drop_front(5));
+  if (node_cache)
+    cacheNode(cidToKey(cid), buffer);
+  return cid;
 }
 
-static void sendResult(const ojson &node) {
-  std::lock_guard lock(result_mutex);
-  if (result_uri.empty())
-    return;
+static void putResult(const std::string &call_uri, const ojson &node) {
   auto cid = putNode(node);
   std::string buffer;
   encode_cbor(cid, buffer);
-  auto result = session->Put(result_uri.c_str(), cbor_headers, buffer,
-                             "application/cbor");
+  auto result = getSession().Put(call_uri.c_str(), cbor_headers, buffer,
+                                 "application/cbor");
   checkResult(result);
+}
+
+static void sendResult(const ojson &node) {
+  std::lock_guard lock(result_mutex);
+  if (result_uri.empty())
+    return;
+  putResult(result_uri, node);
+  result_uri.clear();
+}
+
+// Report the prefetched job as abandoned, since this process is about to exit.
+static void abandonPrefetchedJob() {
+  std::unique_lock lock(prefetch_mutex);
+  // Wait a little for a claim in flight. If the server hands out a job after
+  // this, it sees the connection drop instead.
+  prefetch_cv.wait_for(lock, std::chrono::seconds(5),
+                       [] { return !prefetch_pending; });
+  if (prefetched_uri.empty())
+    return;
+  putResult(prefetched_uri,
+            ojson(json_object_arg, {{"status", "error"},
+                                    {"error", "abandoned prefetched job"}}));
+  prefetched_uri.clear();
+}
+
+// Hand the result of the current job to uploadThread().
+static void queueResult(ojson &&node) {
+  // Hold result_mutex until the result is queued, so a timeout that happens
+  // in between sees either result_uri or the queued result.
+  std::lock_guard lock(result_mutex);
+  if (result_uri.empty())
+    return;
+  std::unique_lock upload_lock(upload_mutex);
+  upload_queue.emplace_back(std::move(result_uri), std::move(node));
+  upload_lock.unlock();
+  upload_cv.notify_all();
   result_uri.clear();
 }
 
+static void uploadThread() {
+  std::unique_lock lock(upload_mutex);
+  while (true) {
+    upload_cv.wait(lock,
+                   [] { return !upload_queue.empty() || upload_cancelled; });
+    if (upload_cancelled)
+      return;
+    auto [call_uri, node] = std::move(upload_queue.front());
+    upload_queue.pop_front();
+    upload_busy = true;
+    lock.unlock();
+
+    if (node.contains("test_input"))
+      node["test_input"] = putNode(node["test_input"]);
+    putResult(call_uri, node);
+
+    lock.lock();
+    upload_busy = false;
+    upload_cv.notify_all();
+  }
+}
+
+// Wait until uploadThread() has sent every queued result.
+static void flushResults() {
+  if (!opt_prefetch)
+    return;
+  std::unique_lock lock(upload_mutex);
+  upload_cv.wait(lock, [] {
+    return (upload_queue.empty() && !upload_busy) || upload_cancelled;
+  });
+}
+
 // Must be signal-safe.
 static void signalHandler(void *) {
+  // The supervisor process doesn't run the helper threads.
+  if (!crash_handler_started)
+    return;
+
   // Resume the signal handler thread.
   sem_post(&crash_sem);
 
@@ -186,6 +461,8 @@ static void crashHandlerThread() {
 
   std::cerr << "crashed\n";
   sendResult(ojson(json_object_arg, {{"status", "crashed"}}));
+  abandonPrefetchedJob();
+  flushResults();
 
   // Tell signalHandler() we're done.
   crash_handler_done = 1;
@@ -215,6 +492,8 @@ static void timeoutThread() {
   }
 
   sendResult(ojson(json_object_arg, {{"status", "timeout"}}));
+  abandonPrefetchedJob();
+  flushResults();
 
   // We can't call exit() because that would destroy the global SMT context
   // while another thread might be using it.
@@ -228,19 +507,357 @@ static void exitHandler() {
   std::lock_guard lock(timeout_mutex);
   timeout_cancelled = true;
   timeout_cv.notify_all();
+
+  // Same for upload_cv and prefetch_cv.
+  std::lock_guard upload_lock(upload_mutex);
+  upload_cancelled = true;
+  upload_cv.notify_all();
+
+  std::lock_guard prefetch_lock(prefetch_mutex);
+  prefetch_cancelled = true;
+  prefetch_cv.notify_all();
+}
+
+// Start the crash and timeout threads. Threads don't survive fork(), so each
+// worker process has to call this itself.
+static void startHelperThreads() {
+  std::thread(crashHandlerThread).detach();
+  std::thread(timeoutThread).detach();
+  if (opt_prefetch)
+    std::thread(uploadThread).detach();
+  crash_handler_started = 1;
+}
+
+namespace {
+struct Job {
+  // Each arg has been replaced by the node it refers to, except byte strings,
+  // which are replaced by null and point into raw_nodes through raw_args.
+  ojson job;
+  ojson arg_cids;
+  std::string call_uri;
+  std::vector<RawNode> raw_nodes;
+  std::vector<std::string_view> raw_args;
+};
+} // end anonymous namespace
+
+// See prefetched_uri.
+static std::optional<Job> prefetched_job;
+
+static std::pair<std::string, uint64_t> getResultCacheKey(const Job &job) {
+  const auto &func = job.job["func"].as_string_view();
+  ojson options = job.job["args"][0];
+  uint64_t budget = takeJobBudget(std::string(func), options);
+
+  std::string key(func);
+  for (size_t i = 1; i < job.arg_cids.size(); ++i)
+    key += "," + binaryCIDToText(job.arg_cids[i]);
+  key += "," + options.to_string();
+  return {std::move(key), budget};
+}
+
+
+static std::optional<ojson> lookupResult(const Job &job) {
+  auto [key, budget] = getResultCacheKey(job);
+  // 'r' entries hold definitive results, 'b' ones ran out of budget.
+  for (char kind : {'r', 'b'}) {
+    auto file = result_cache->get(hash_cache_key(kind, key));
+    if (!file)
+      continue;
+    ojson entry;
+    try {
+      entry = decode_cbor<ojson>(*file);
+    } catch (const jsoncons::ser_error &) {
+      continue;
+    }
+    if (entry["job"].as_string_view() != key)
+      continue; // hash collision
+    if (kind == 'b' && entry["budget"].as<uint64_t>() < budget)
+      continue; // may succeed with a larger budget
+    // The stats measured the original evaluation, not this one.
+    ojson result = std::move(entry["result"]);
+    result.erase("stats");
+    result["cached"] = true;
+    return result;
+  }
+  return {};
+}
+
+static void storeResult(const Job &job, const ojson &result) {
+  auto [key, budget] = getResultCacheKey(job);
+  ojson entry(json_object_arg,
+              {{"job", key}, {"budget", budget}, {"result", result}});
+  std::string buffer;
+  encode_cbor(entry, buffer);
+  result_cache->put(hash_cache_key(isOutOfBudget(result) ? 'b' : 'r', key),
+                    buffer);
+}
+
+// Ask the server for a job and download its arguments. Returns nothing if no
+// jobs are available.
+static std::optional<Job> claimJob(const ojson &worker_info_cid) {
+  std::string buffer;
+  encode_cbor(worker_info_cid, buffer);
+  auto response =
+      getSession().Post("/worker", cbor_headers, buffer, "application/cbor");
+  checkResult(response);
+  if (response->get_header_value("Content-Type") != "application/cbor") {
+    std::cerr << "unexpected Content-Type!\n";
+    exitWorker(1);
+  }
+  ojson job = decode_cbor<ojson>(response->body);
+  if (job.is_null())
+    return {};
+
+  string func = job["func"].as<string>();
+  std::string call_uri = "/call/" + func + "/";
+  ojson arg_cids = job["args"];
+  std::vector<RawNode> raw_nodes;
+  std::vector<std::string_view> raw_args;
+  // raw_args point into raw_nodes, so they must never reallocate
+  raw_nodes.reserve(arg_cids.size());
+  for (ojson &arg : job["args"].array_range()) {
+    call_uri += binaryCIDToText(arg) + ",";
+    const RawNode &raw = raw_nodes.emplace_back(getRawNodeFromCID(arg));
+    raw_args.resize(raw_nodes.size());
+    if (auto bytes = getByteStringContents(raw.data())) {
+      raw_args.back() = *bytes;
+      arg = nullptr;
+    } else {
+      arg = decodeNode(arg, raw);
+      raw_nodes.back() = RawNode();
+    }
+  }
+  call_uri.pop_back(); // remove last comma
+  return Job{std::move(job), std::move(arg_cids), std::move(call_uri),
+             std::move(raw_nodes), std::move(raw_args)};
+}
+
+// Claims a job whenever workerLoop() sets prefetch_pending. A single thread
+// does it, so its connection to the server is reused.
+static void prefetchThread(ojson worker_info_cid) {
+  std::unique_lock lock(prefetch_mutex);
+  while (true) {
+    prefetch_cv.wait(lock,
+                     [] { return prefetch_pending || prefetch_cancelled; });
+    if (prefetch_cancelled)
+      return;
+    lock.unlock();
+    auto job = claimJob(worker_info_cid);
+    lock.lock();
+    if (job)
+      prefetched_uri = job->call_uri;
+    prefetched_job = std::move(job);
+    prefetch_pending = false;
+    prefetch_cv.notify_all();
+  }
+}
+
+// Waits for the claim of prefetchThread() to finish. Returns nothing if no
+// jobs were available.
+static std::optional<Job> takePrefetchedJob() {
+  std::unique_lock lock(prefetch_mutex);
+  prefetch_cv.wait(lock, [] { return !prefetch_pending; });
+  auto job = std::move(prefetched_job);
+  prefetched_job.reset();
+  return job;
+}
+
+namespace {
+// Decides how long an idle worker waits before polling the server again.
+//
+// memodb-server holds POST /worker open until a job is available or its
+// long-poll timeout expires, so an empty response that took a while means the
+// server is long-polling and we can ask again right away: we will be woken as
+// soon as there is work, without loading the server. Quick empty responses
+// mean it isn't, so we back off exponentially, with jitter so that many
+// workers don't poll in lockstep.
+class PollScheduler {
+  // Empty responses at least this slow count as long polls.
+  static constexpr std::chrono::seconds long_poll_min{5};
+
+  std::minstd_rand rng;
+  std::chrono::milliseconds delay{0};
+  std::chrono::steady_clock::time_point idle_start;
+  unsigned num_empty = 0, num_long_polls = 0;
+  float total_delay = 0; // in seconds
+
+public:
+  PollScheduler() : rng(std::random_device()()) {}
+
+  // Returns how long to wait after an empty response that took poll_time.
+  std::chrono::milliseconds noJob(std::chrono::duration<float> poll_time);
+  // Reports the idle period that just ended, if any.
+  void gotJob();
+};
+} // end anonymous namespace
+
+std::chrono::milliseconds
+PollScheduler::noJob(std::chrono::duration<float> poll_time) {
+  if (num_empty++ == 0)
+    idle_start = std::chrono::steady_clock::now();
+  if (poll_time >= long_poll_min) {
+    ++num_long_polls;
+    delay = std::chrono::milliseconds(0);
+    return delay;
+  }
+
+  std::chrono::milliseconds min_delay(opt_poll_min_delay),
+      max_delay(std::max(opt_poll_min_delay, opt_poll_max_delay));
+  delay = std::clamp(delay * 2, min_delay, max_delay);
+  // "Equal jitter": wait between half and all of the delay.
+  std::uniform_int_distribution<long> dist(delay.count() / 2, delay.count());
+  std::chrono::milliseconds wait(dist(rng));
+  total_delay += std::chrono::duration<float>(wait).count();
+  return wait;
+}
+
+void PollScheduler::gotJob() {
+  if (num_empty) {
+    std::chrono::duration<float> idle =
+        std::chrono::steady_clock::now() - idle_start;
+    llvm::errs() << llvm::format("idle for %.1fs: %u empty polls (%u long "
+                                 "polls), %.1fs of backoff\n",
+                                 idle.count(), num_empty, num_long_polls,
+                                 total_delay);
+  }
+  delay = std::chrono::milliseconds(0);
+  num_empty = num_long_polls = 0;
+  total_delay = 0;
+}
+
+static int workerLoop(const ojson &worker_info_cid) {
+  if (opt_prefetch)
+    std::thread(prefetchThread, worker_info_cid).detach();
+
+  bool prefetching = false;
+  PollScheduler poll;
+  while (true) {
+    std::optional<Job> claimed;
+    // A background poll is not timed, so it never counts as a long poll.
+    std::chrono::duration<float> poll_time(0);
+    if (prefetching) {
+      claimed = takePrefetchedJob();
+      prefetching = false;
+    } else {
+      auto start = std::chrono::steady_clock::now();
+      claimed = claimJob(worker_info_cid);
+      poll_time = std::chrono::steady_clock::now() - start;
+    }
+    if (!claimed) {
+      // No jobs available, try again.
+      std::this_thread::sleep_for(poll.noJob(poll_time));
+      continue;
+    }
+    poll.gotJob();
+    auto &[job, arg_cids, call_uri, raw_nodes, raw_args] = *claimed;
+
+    {
+      std::scoped_lock lock(result_mutex, prefetch_mutex);
+      result_uri = call_uri;
+      prefetched_uri.clear(); // this job, if it was prefetched
+      // Fetch the next job over the network while this one is evaluated.
+      if (opt_prefetch) {
+        prefetch_pending = true;
+        prefetching = true;
+        prefetch_cv.notify_all();
+      }
+    }
+
+    llvm::errs() << "evaluating " << call_uri << "\n";
+
+    uint64_t timeout =
+        job["args"][0].get_with_default<uint64_t>("timeout", 60000);
+    std::unique_lock lock(timeout_mutex);
+    timeout_millis = timeout;
+    timeout_index++;
+    lock.unlock();
+    timeout_cv.notify_one();
+
+    std::optional<ojson> result;
+    if (result_cache)
+      result = lookupResult(*claimed);
+    if (result) {
+      llvm::errs() << "reusing result of " << call_uri << "\n";
+    } else {
+      result = evaluateAliveFunc(job, raw_args);
+      if (result_cache)
+        storeResult(*claimed, *result);
+    }
+
+    if (!opt_prefetch && result->contains("test_input"))
+      (*result)["test_input"] = putNode((*result)["test_input"]);
+
+    lock.lock();
+    timeout_millis = 0;
+    lock.unlock();
+    timeout_cv.notify_one();
+
+    if (opt_prefetch)
+      queueResult(std::move(*result)); // uploads test_input too
+    else
+      sendResult(*result);
+  }
+}
+
+static pid_t forkWorker(const ojson &worker_info_cid) {
+  pid_t pid = fork();
+  if (pid == -1) {
+    perror("fork() failed");
+    std::exit(1);
+  }
+  if (pid != 0)
+    return pid;
+
+  // Don't reuse the supervisor's connection.
+  session.reset();
+  startHelperThreads();
+  std::exit(workerLoop(worker_info_cid));
+}
+
+// Keep opt_jobs worker processes running, replacing each one that exits.
+// Never returns.
+static void runSupervisor(const ojson &worker_info_cid) {
+  std::vector<std::pair<pid_t, time_t>> workers; // pid, start time
+  for (unsigned i = 0; i < opt_jobs; ++i)
+    workers.emplace_back(forkWorker(worker_info_cid), time(nullptr));
+
+  while (true) {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid == -1) {
+      if (errno == EINTR)
+        continue;
+      perror("waitpid() failed");
+      std::exit(1);
+    }
+
+    auto I = find_if(workers.begin(), workers.end(),
+                     [&](auto &w) { return w.first == pid; });
+    if (I == workers.end())
+      continue;
+
+    if (WIFSIGNALED(status))
+      std::cerr << "worker " << pid << " killed by signal "
+                << WTERMSIG(status) << '\n';
+    else if (WIFEXITED(status) && WEXITSTATUS(status) != 2) // 2 is a timeout
+      std::cerr << "worker " << pid << " exited with status "
+                << WEXITSTATUS(status) << '\n';
+
+    // Avoid spinning if workers die right away (e.g., the server is down).
+    if (time(nullptr) - I->second < 1)
+      sleep(1);
+
+    *I = {forkWorker(worker_info_cid), time(nullptr)};
+  }
 }
 
 int main(int argc, char **argv) {
   // Register our signal handler before LLVM's stack trace printer, so our
   // handler will run first.
+  main_thread = std::this_thread::get_id();
   sem_init(&crash_sem, 0, 0);
   llvm::sys::AddSignalHandler(signalHandler, nullptr);
-
-  // Start our threads before calling anything else from LLVM, in case LLVM's
-  // functions crash.
   atexit(exitHandler);
-  std::thread(crashHandlerThread).detach();
-  std::thread(timeoutThread).detach();
 
   llvm::sys::PrintStackTraceOnErrorSignal(argv[0]);
   llvm::PrettyStackTraceProgram X(argc, argv);
@@ -261,70 +878,37 @@ calls that are submitted to the server by other programs.
   llvm::cl::HideUnrelatedOptions(alive_cmdargs);
   llvm::cl::ParseCommandLineOptions(argc, argv, Usage);
 
-  std::string server_url = opt_url;
+  // Without a supervisor, start our threads before doing any real work, in
+  // case it crashes.
+  if (!opt_jobs)
+    startHelperThreads();
+
+  server_url = opt_url;
   // httplib doesn't like the ending slash in http://127.0.0.1:1234/
   if (!server_url.empty() && server_url.back() == '/')
     server_url.pop_back();
-  session.emplace(server_url);
+
+  if (!opt_cache_dir.empty())
+    node_cache.emplace(opt_cache_dir, uint64_t(opt_cache_size) * 1024 * 1024);
+  if (!opt_result_cache_dir.empty())
+    result_cache.emplace(opt_result_cache_dir,
+                         uint64_t(opt_result_cache_size) * 1024 * 1024);
 
   // Upload the list of funcs we can evaluate using POST /cid.
   ojson worker_info(
       json_object_arg,
       {
-          {"funcs", ojson(json_array_arg, {"alive.tv_v2", "alive.interpret"})},
+          {"funcs", ojson(json_array_arg,
+                          {"alive.tv_v2", "alive.tv_batch", "alive.interpret",
+                           "alive.interpret_batch"})},
       });
   auto worker_info_cid = putNode(worker_info);
 
-  while (true) {
-    std::string buffer;
-    encode_cbor(worker_info_cid, buffer);
-    auto response =
-        session->Post("/worker", cbor_headers, buffer, "application/cbor");
-    checkResult(response);
-    if (response->get_header_value("Content-Type") != "application/cbor") {
-      std::cerr << "unexpected Content-Type!\n";
-      return 1;
-    }
-    ojson job = decode_cbor<ojson>(response->body);
-    if (job.is_null()) {
-      // No jobs available, try again.
-      sleep(1); // TODO: exponential backoff
-      continue;
-    }
-
-    string func = job["func"].as<string>();
-    std::string call_uri = "/call/" + func + "/";
-    for (ojson &arg : job["args"].array_range()) {
-      call_uri += binaryCIDToText(arg) + ",";
-      arg = getNodeFromCID(arg);
-    }
-    call_uri.pop_back(); // remove last comma
-    llvm::errs() << "evaluating " << call_uri << "\n";
-
-    std::unique_lock lock(result_mutex);
-    result_uri = call_uri;
-    lock.unlock();
-
-    uint64_t timeout =
-        job["args"][0].get_with_default<uint64_t>("timeout", 60000);
-    lock = unique_lock(timeout_mutex);
-    timeout_millis = timeout;
-    timeout_index++;
-    lock.unlock();
-    timeout_cv.notify_one();
-
-    ojson result = evaluateAliveFunc(job);
-
-    if (result.contains("test_input"))
-      result["test_input"] = putNode(result["test_input"]);
-
-    lock.lock();
-    timeout_millis = 0;
-    lock.unlock();
-    timeout_cv.notify_one();
-
-    sendResult(result);
+  if (opt_jobs) {
+    // Workers are forked from this state, so they start warm.
+    initAliveWorker();
+    runSupervisor(worker_info_cid);
   }
 
-  return 0;
+  return workerLoop(worker_info_cid);
 }
@@ -61,9 +61,11 @@ int main(int argc, char **argv) {
       smt::set_query_timeout(arg.substr(8).data());
     else if (arg.compare(0, 17, "-smt-random-seed:") == 0 && arg.size() > 17)
       smt::set_random_seed(arg.substr(17).data());
-    else if (arg.compare(0, 9, "-max-mem:") == 0 && arg.size() > 9)
+    else if (arg.compare(0, 9, "-max-mem:") == 0 && arg.size() > 9) {
       smt::set_memory_limit(strtoul(arg.substr(9).data(), nullptr, 10) *
                             1024 * 1024);
+      smt::solver_memory_governor(true);
+    }
     else if (arg == "-smt-verbose")
       smt::solver_print_queries(true);
     else if (arg == "-tactic-verbose")
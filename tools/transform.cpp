@@ -123,6 +123,11 @@ bool Errors::addSolverError(const Result &r) {
     return false;
   }
 
+  if (r.isMemout()) {
+    errs.add("Out of memory", false);
+    return false;
+  }
+
   if (r.isError()) {
     errs.add("SMT Error: " + r.getReason(), false);
     return false;
@@ -409,14 +414,29 @@ check_refinement(Errors &errs, const Transform &t, const State &src_state,
                  const expr &fndom_a, const State::ValTy &ap,
                  const expr &fndom_b, const State::ValTy &bp,
                  bool check_each_var) {
-  if (check_expr(!src_state.sinkDomain()).isUnsat()) {
+  // All checks share one solver: the axioms are asserted once and each check
+  // adds its formula in its own scope. The solver is built from a tactic,
+  // which Z3 re-runs from scratch on every check, so nothing learned in one
+  // check is reused by the next. Z3's incremental solver would keep its
+  // lemmas, but it skips our preprocessing (qe-light in particular) and is
+  // much slower on the refinement queries.
+  Solver s;
+  QueryLabel fn_label(t.src.getName(), "other");
+  auto check_scoped = [&](expr &&e, const char *kind) {
+    QueryLabel label(kind);
+    SolverPush push(s);
+    s.add(std::move(e));
+    return s.check();
+  };
+
+  if (check_scoped(!src_state.sinkDomain(), "sink_src").isUnsat()) {
     errs.add("The source program doesn't reach a return instruction.\n"
              "Consider increasing the unroll factor if it has loops", false);
     return;
   }
 
   auto sink_tgt = tgt_state.sinkDomain();
-  if (check_expr(!sink_tgt).isUnsat()) {
+  if (check_scoped(!sink_tgt, "sink_tgt").isUnsat()) {
     errs.add("The target program doesn't reach a return instruction.\n"
              "Consider increasing the unroll factor if it has loops", false);
     return;
@@ -449,10 +469,10 @@ check_refinement(Errors &errs, const Transform &t, const State &src_state,
   expr pre_src = pre_src_and();
   expr pre_tgt = pre_tgt_and();
 
-  expr axioms_expr = axioms();
+  s.add(axioms());
   pre_tgt &= !sink_tgt;
 
-  if (check_expr(axioms_expr && (pre_src && pre_tgt)).isUnsat()) {
+  if (check_scoped(pre_src && pre_tgt, "precondition").isUnsat()) {
     errs.add("Precondition is always false", false);
     return;
   }
@@ -481,26 +501,39 @@ check_refinement(Errors &errs, const Transform &t, const State &src_state,
     if (refines.isFalse())
       return std::move(refines);
 
-    return axioms_expr &&
-            preprocess(t, qvars, uvars, pre && pre_src_forall.implies(refines));
+    return preprocess(t, qvars, uvars, pre && pre_src_forall.implies(refines));
   };
 
-  auto check = [&](expr &&e, auto &&printer, const char *msg) {
-    e = mk_fml(std::move(e));
-    auto res = check_expr(e);
-    if (!res.isUnsat() &&
-        !error(errs, src_state, tgt_state, res, var, msg, check_each_var,
-               printer))
-      return false;
-    return true;
+  auto report = [&](const Result &res, auto &&printer, const char *msg) {
+    return res.isUnsat() ||
+           error(errs, src_state, tgt_state, res, var, msg, check_each_var,
+                 printer);
   };
 
-#define CHECK(fml, printer, msg) \
-  if (!check(fml, printer, msg)) \
+  // with parallel checks, the formulas are only collected here and solved
+  // all at once at the end
+  vector<expr> fmls;
+  vector<const char*> kinds;
+  vector<pair<print_var_val_ty, const char*>> reporters;
+
+  auto check = [&](expr &&e, const char *kind, auto &&printer,
+                   const char *msg) {
+    auto fml = mk_fml(std::move(e));
+    if (config::parallel_checks) {
+      fmls.emplace_back(std::move(fml));
+      kinds.emplace_back(kind);
+      reporters.emplace_back(printer, msg);
+      return true;
+    }
+    return report(check_scoped(std::move(fml), kind), printer, msg);
+  };
+
+#define CHECK(fml, kind, printer, msg) \
+  if (!check(fml, kind, printer, msg)) \
     return
 
   // 1. Check UB
-  CHECK(fndom_a.notImplies(fndom_b),
+  CHECK(fndom_a.notImplies(fndom_b), "ub",
         [](ostream&, const Model&){}, "Source is more defined than target");
 
   // 2. Check return domain (noreturn check)
@@ -512,7 +545,7 @@ check_refinement(Errors &errs, const Transform &t, const State &src_state,
       dom_constr = (fndom_a && fndom_b) && dom_a != dom_b;
     }
 
-    CHECK(std::move(dom_constr),
+    CHECK(std::move(dom_constr), "return_domain",
           [](ostream&, const Model&){},
           "Source and target don't have the same return domain");
   }
@@ -528,15 +561,15 @@ check_refinement(Errors &errs, const Transform &t, const State &src_state,
   auto [poison_cnstr, value_cnstr] = type.refines(src_state, tgt_state, a, b);
   expr dom = dom_a && dom_b;
 
-  CHECK(dom && !poison_cnstr,
+  CHECK(dom && !poison_cnstr, "poison",
         print_value, "Target is more poisonous than source");
 
   // 4. Check undef
-  CHECK(dom && encode_undef_refinement(type, ap, bp),
+  CHECK(dom && encode_undef_refinement(type, ap, bp), "undef",
         print_value, "Target's return value is more undefined");
 
   // 5. Check value
-  CHECK(dom && !value_cnstr, print_value, "Value mismatch");
+  CHECK(dom && !value_cnstr, "value", print_value, "Value mismatch");
 
   // 6. Check memory
   auto src_mem = src_state.returnMemory();
@@ -556,9 +589,20 @@ check_refinement(Errors &errs, const Transform &t, const State &src_state,
 
   CHECK(dom && !(memory_cnstr0.isTrue() ? memory_cnstr0
                                         : value_cnstr && memory_cnstr0),
-        print_ptr_load, "Mismatch in memory");
+        "memory", print_ptr_load, "Mismatch in memory");
 
 #undef CHECK
+
+  // Report in the same order as the sequential checks; any remaining ones
+  // are canceled once a check fails.
+  if (!fmls.empty()) {
+    ParallelCheck par(s, fmls, kinds);
+    for (unsigned i = 0; i < fmls.size(); ++i) {
+      auto &[printer, msg] = reporters[i];
+      if (!report(par.get(i), printer, msg))
+        return;
+    }
+  }
 }
 
 static bool has_nullptr(const Value *v) {
@@ -4,6 +4,7 @@
 #include "ir/memory.h"
 #include "llvm_util/llvm2alive.h"
 #include "llvm_util/utils.h"
+#include "smt/expr.h"
 #include "smt/smt.h"
 #include "smt/solver.h"
 #include "tools/transform.h"
@@ -106,6 +107,8 @@ static void showStats() {
     smt::solver_print_stats(*out);
   if (opt_alias_stats)
     IR::Memory::printAliasStats(*out);
+  if (opt_fold_stats)
+    smt::expr_print_fold_stats(*out);
 }
 
 
@@ -344,6 +347,14 @@ struct TVLegacyPass final : public llvm::ModulePass {
       set_outs(*out);
     }
 
+    // Once all children are done, so the queue is retried only once
+    if (opt_smt_retry_to && !config::smt_retry_dir.empty()) {
+      *out << "Retrying timed out queries:\n";
+      auto retry = smt::solver_retry_queue(config::smt_retry_dir,
+                                           opt_smt_retry_to, *out);
+      has_failure |= retry.num_incorrect > 0;
+    }
+
     // If it is run in parallel, stats are shown by children
     if (!showed_stats && !parallelMgr) {
       showed_stats = true;
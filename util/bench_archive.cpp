@@ -0,0 +1,217 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/bench_archive.h"
+#include "util/disk_cache.h"
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/file.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static void put_u32(string &buf, uint32_t n) {
+  for (unsigned i = 0; i < 4; ++i) {
+    buf += char(n >> (8 * i));
+  }
+}
+
+static uint32_t get_u32(const char *p) {
+  uint32_t n = 0;
+  for (unsigned i = 0; i < 4; ++i) {
+    n |= uint32_t((unsigned char)p[i]) << (8 * i);
+  }
+  return n;
+}
+
+namespace util {
+
+BenchArchive::BenchArchive(const string &dir) : dir(dir) {
+  error_code ec;
+  fs::create_directories(dir, ec);
+}
+
+BenchArchive::~BenchArchive() {
+  close();
+}
+
+void BenchArchive::open() {
+  // Locks are shared by forked processes that inherit the descriptors, so
+  // each process opens the files itself.
+  close();
+  pid = getpid();
+  auto path = fs::path(dir);
+  index_fd = ::open((path / "index").c_str(),
+                    O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  data_fd = ::open((path / "queries").c_str(),
+                   O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+void BenchArchive::close() {
+  if (index_fd != -1)
+    ::close(index_fd);
+  if (data_fd != -1)
+    ::close(data_fd);
+  index_fd = data_fd = -1;
+}
+
+void BenchArchive::readIndex() {
+  // Other processes append to the index concurrently, so only consume
+  // complete lines.
+  char buf[1 << 16];
+  string pending;
+  while (true) {
+    auto n = pread(index_fd, buf, sizeof(buf), index_pos + pending.size());
+    if (n <= 0)
+      break;
+    pending.append(buf, n);
+  }
+
+  size_t start = 0;
+  for (size_t end; (end = pending.find('\n', start)) != string::npos;
+       start = end + 1) {
+    auto space = pending.find(' ', start);
+    if (space < end)
+      known.emplace(pending, start, space - start);
+  }
+  index_pos += start;
+}
+
+void BenchArchive::appendIndex(const string &line) {
+  // A single write with O_APPEND, so concurrent lines don't interleave
+  write_all(index_fd, line);
+}
+
+void BenchArchive::add(string_view query, string_view location) {
+  if (pid != getpid())
+    open();
+  if (index_fd == -1 || data_fd == -1)
+    return;
+
+  string loc(location);
+  for (char &c : loc) {
+    if (c == '\n' || c == '\r')
+      c = ' ';
+  }
+
+  auto hash = to_hex(hash_data(query));
+  if (known.count(hash)) {
+    appendIndex(hash + " + " + loc + '\n');
+    return;
+  }
+
+  // Writers of new queries hold the index lock, so the data file offset is
+  // stable and two processes don't store the same query.
+  if (flock(index_fd, LOCK_EX) != 0)
+    return;
+
+  readIndex();
+  if (known.count(hash)) {
+    appendIndex(hash + " + " + loc + '\n');
+    flock(index_fd, LOCK_UN);
+    return;
+  }
+
+  string record;
+  put_u32(record, query.size());
+  const char *stored = query.data();
+  size_t stored_size = query.size();
+#ifdef HAVE_ZLIB
+  uLongf size = compressBound(query.size());
+  vector<Bytef> compressed(size);
+  if (compress2(compressed.data(), &size, (const Bytef*)query.data(),
+                query.size(), Z_DEFAULT_COMPRESSION) == Z_OK &&
+      size < query.size()) {
+    stored = (const char*)compressed.data();
+    stored_size = size;
+  }
+#endif
+  put_u32(record, stored_size);
+  record.append(stored, stored_size);
+
+  auto offset = lseek(data_fd, 0, SEEK_END);
+  if (offset != -1 && write_all(data_fd, record)) {
+    appendIndex(hash + ' ' + to_string(offset) + ' ' + loc + '\n');
+    known.emplace(std::move(hash));
+  }
+  flock(index_fd, LOCK_UN);
+}
+
+vector<BenchArchive::Query> BenchArchive::read(const string &dir) {
+  auto path = fs::path(dir);
+  MappedFile index((path / "index").c_str());
+  MappedFile data((path / "queries").c_str());
+  if (!index || !data)
+    return {};
+
+  // Queries are stored and indexed under the lock, so their first index lines
+  // are in the order they were stored.
+  vector<Query> queries;
+  vector<uint64_t> offsets;
+  unordered_map<string, unsigned> ids;
+
+  string_view lines = *index;
+  for (size_t end; (end = lines.find('\n')) != string_view::npos;
+       lines.remove_prefix(end + 1)) {
+    auto line = lines.substr(0, end);
+    auto sp1 = line.find(' ');
+    auto sp2 = line.find(' ', sp1 + 1);
+    if (sp2 == string_view::npos)
+      continue;
+    string hash(line.substr(0, sp1));
+    auto offset = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    auto [I, inserted] = ids.try_emplace(hash, queries.size());
+    if (inserted) {
+      queries.emplace_back();
+      queries.back().hash = std::move(hash);
+      offsets.emplace_back(UINT64_MAX);
+    }
+    auto &q = queries[I->second];
+    ++q.hits;
+    if (offset != "+" && offsets[I->second] == UINT64_MAX) {
+      offsets[I->second] = strtoull(string(offset).c_str(), nullptr, 10);
+      q.location = line.substr(sp2 + 1);
+    }
+  }
+
+  vector<Query> result;
+  string_view bytes = *data;
+  for (unsigned i = 0, e = queries.size(); i != e; ++i) {
+    auto offset = offsets[i];
+    if (offset == UINT64_MAX || offset + 8 > bytes.size())
+      continue;
+    uint32_t size = get_u32(bytes.data() + offset);
+    uint32_t stored_size = get_u32(bytes.data() + offset + 4);
+    if (offset + 8 + stored_size > bytes.size())
+      continue;
+    auto stored = bytes.substr(offset + 8, stored_size);
+
+    auto &q = queries[i];
+    if (size == stored_size) {
+      q.text = stored;
+    } else {
+#ifdef HAVE_ZLIB
+      q.text.resize(size);
+      uLongf len = size;
+      if (uncompress((Bytef*)q.text.data(), &len, (const Bytef*)stored.data(),
+                     stored.size()) != Z_OK || len != size)
+        continue;
+#else
+      continue;
+#endif
+    }
+    result.emplace_back(std::move(q));
+  }
+
+  return result;
+}
+
+}
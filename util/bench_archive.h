@@ -0,0 +1,57 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_set>
+#include <vector>
+
+namespace util {
+
+// An append-only archive of SMT-LIB benchmarks, which can be shared by
+// concurrent processes. Each distinct query is stored once, compressed with
+// zlib when available, in the 'queries' file. The 'index' file has a line per
+// query seen:
+//   <hash> <offset> <location>   the first time the query is seen
+//   <hash> + <location>          every other time
+// so the hit count of a query is its number of index lines.
+// Records in 'queries' are a 4-byte little-endian query size, a 4-byte stored
+// size, and the stored bytes; the query is stored uncompressed if both sizes
+// are equal.
+// Failures to write the archive are ignored.
+class BenchArchive {
+  std::string dir;
+  pid_t pid = -1; // the process that opened the files
+  int index_fd = -1;
+  int data_fd = -1;
+  size_t index_pos = 0; // how much of the index has been read
+  std::unordered_set<std::string> known;
+
+  void open();
+  void close();
+  void readIndex();
+  void appendIndex(const std::string &line);
+
+public:
+  BenchArchive(const std::string &dir);
+  BenchArchive(const BenchArchive &) = delete;
+  ~BenchArchive();
+
+  void add(std::string_view query, std::string_view location);
+
+  struct Query {
+    std::string hash;
+    std::string location; // where it was first seen
+    unsigned hits = 0;
+    std::string text;
+  };
+
+  // Returns the queries of the archive in dir, in the order they were stored.
+  // Queries that can't be read are skipped.
+  static std::vector<Query> read(const std::string &dir);
+};
+
+}
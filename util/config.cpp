@@ -13,6 +13,11 @@ namespace util::config {
 bool symexec_print_each_value = false;
 bool skip_smt = false;
 string smt_benchmark_dir;
+string smt_telemetry_file;
+string smt_retry_dir;
+string smt_cache_dir;
+uint64_t smt_cache_max_size = 1ull << 30; // 1 GB
+bool parallel_checks = false;
 bool disable_poison_input = false;
 bool disable_undef_input = false;
 bool debug = false;
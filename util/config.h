@@ -3,6 +3,7 @@
 // Copyright (c) 2018-present The Alive2 Authors.
 // Distributed under the MIT license that can be found in the LICENSE file.
 
+#include <cstdint>
 #include <string>
 #include <ostream>
 
@@ -15,6 +16,22 @@ extern bool skip_smt;
 // don't dumo if empty
 extern std::string smt_benchmark_dir;
 
+// File to append a JSON line per SMT query to. Disabled if empty.
+extern std::string smt_telemetry_file;
+
+// Directory to queue the SMT queries that time out in, to retry them later
+// with larger timeouts. Disabled if empty.
+extern std::string smt_retry_dir;
+
+// Directory to cache UNSAT and TIMEOUT verdicts of SMT queries across runs.
+// Disabled if empty.
+extern std::string smt_cache_dir;
+extern uint64_t smt_cache_max_size;
+
+// Solve the refinement checks of a transformation concurrently in forked
+// processes.
+extern bool parallel_checks;
+
 extern bool disable_poison_input;
 
 extern bool disable_undef_input;
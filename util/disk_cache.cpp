@@ -0,0 +1,178 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/disk_cache.h"
+#include "util/random.h"
+#include <algorithm>
+#include <cassert>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace util {
+
+MappedFile::MappedFile(const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1)
+    return;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      ptr = p;
+      sz = st.st_size;
+    }
+  }
+  close(fd);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+  swap(ptr, other.ptr);
+  swap(sz, other.sz);
+}
+
+void MappedFile::operator=(MappedFile &&other) noexcept {
+  swap(ptr, other.ptr);
+  swap(sz, other.sz);
+}
+
+MappedFile::~MappedFile() {
+  if (ptr)
+    munmap(ptr, sz);
+}
+
+
+DataHash hash_data(string_view data) {
+  uint64_t h1 = 0xcbf29ce484222325ull, h2 = 0x84222325cbf29ce4ull;
+  for (unsigned char c : data) {
+    h1 = (h1 ^ c) * 0x100000001b3ull;
+    h2 = (h2 ^ c) * 0x100000001b3ull;
+  }
+  return { h1, h2 };
+}
+
+string to_hex(const DataHash &hash) {
+  static const char hex[] = "0123456789abcdef";
+  string str;
+  for (uint64_t h : { hash.first, hash.second }) {
+    for (int i = 60; i >= 0; i -= 4) {
+      str += hex[(h >> i) & 0xf];
+    }
+  }
+  return str;
+}
+
+bool write_all(int fd, string_view data) {
+  while (!data.empty()) {
+    auto n = write(fd, data.data(), data.size());
+    if (n <= 0)
+      return false;
+    data.remove_prefix(n);
+  }
+  return true;
+}
+
+string hash_cache_key(char prefix, string_view data) {
+  auto [h1, h2] = hash_data(data);
+  string key(1, prefix);
+  for (uint64_t h : { h1, h2, uint64_t(data.size()) }) {
+    key.append(reinterpret_cast<const char*>(&h), sizeof(h));
+  }
+  return key;
+}
+
+DiskCache::DiskCache(const string &dir0, uint64_t max_size)
+  : dir(dir0), max_size(max_size) {
+  error_code ec;
+  fs::create_directories(dir, ec);
+  for (auto &entry : fs::directory_iterator(dir, ec)) {
+    cur_size += entry.file_size(ec);
+  }
+  if (cur_size > max_size)
+    evict();
+}
+
+fs::path DiskCache::getPath(string_view key) const {
+  // keep file names under the usual 255 character limit
+  assert(!key.empty() && key.size() <= 120);
+  static const char hex[] = "0123456789abcdef";
+  string name;
+  name.reserve(key.size() * 2);
+  for (unsigned char c : key) {
+    name += hex[c >> 4];
+    name += hex[c & 0xf];
+  }
+  return dir / name;
+}
+
+MappedFile DiskCache::get(string_view key) {
+  auto path = getPath(key);
+  MappedFile file(path.c_str());
+  // mark as recently used
+  if (file)
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+  return file;
+}
+
+void DiskCache::put(string_view key, string_view data) {
+  // Write to a temporary file first, so other processes never see a partial
+  // entry. Forked processes share the random state, hence the pid.
+  auto tmp = dir / ('.' + to_string(getpid()) + '_' + get_random_str(8));
+  {
+    ofstream file(tmp, ios::binary);
+    if (!file.write(data.data(), data.size()))
+      return;
+  }
+  error_code ec;
+  fs::rename(tmp, getPath(key), ec);
+  if (ec) {
+    fs::remove(tmp, ec);
+    return;
+  }
+
+  lock_guard lock(mutex);
+  cur_size += data.size();
+  if (cur_size > max_size)
+    evict();
+}
+
+void DiskCache::evict() {
+  vector<tuple<fs::file_time_type, uint64_t, fs::path>> files;
+  uint64_t total = 0;
+  error_code ec;
+  for (auto &entry : fs::directory_iterator(dir, ec)) {
+    // skip temporary files of other processes
+    if (entry.path().filename().native()[0] == '.')
+      continue;
+    auto size = entry.file_size(ec);
+    if (ec)
+      continue;
+    auto time = entry.last_write_time(ec);
+    if (ec)
+      continue;
+    files.emplace_back(time, size, entry.path());
+    total += size;
+  }
+
+  // evict down to 3/4 of the limit, so we don't scan the directory on every
+  // insertion
+  sort(files.begin(), files.end());
+  for (auto &[time, size, path] : files) {
+    if (total <= max_size / 4 * 3)
+      break;
+    if (fs::remove(path, ec))
+      total -= size;
+  }
+  cur_size = total;
+}
+
+}
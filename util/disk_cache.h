@@ -0,0 +1,72 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace util {
+
+// Two 64-bit FNV-1a hashes of the data with different offset bases. They are
+// stable across runs and builds, so they can key files shared by processes.
+using DataHash = std::pair<uint64_t, uint64_t>;
+DataHash hash_data(std::string_view data);
+
+// The hash as 32 hex digits.
+std::string to_hex(const DataHash &hash);
+
+// Writes the whole data to fd. Returns false on errors.
+bool write_all(int fd, std::string_view data);
+
+// A read-only memory mapping of a whole file.
+class MappedFile {
+  void *ptr = nullptr;
+  size_t sz = 0;
+
+public:
+  MappedFile() = default;
+  // Leaves the mapping empty if the file can't be opened or is empty.
+  MappedFile(const char *filename);
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  void operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  explicit operator bool() const { return ptr; }
+
+  std::string_view operator*() const {
+    return { (const char*)ptr, sz };
+  }
+};
+
+
+// A directory of files keyed by arbitrary byte strings, which can be shared by
+// concurrent processes and threads. When the files take more than max_size
+// bytes, the least recently used ones are deleted.
+// Failures to read or write the directory are treated as cache misses.
+class DiskCache {
+  std::filesystem::path dir;
+  uint64_t max_size;
+  uint64_t cur_size = 0; // approximate, since other processes write too
+  std::mutex mutex;
+
+  std::filesystem::path getPath(std::string_view key) const;
+  void evict();
+
+public:
+  DiskCache(const std::string &dir, uint64_t max_size);
+
+  MappedFile get(std::string_view key);
+  void put(std::string_view key, std::string_view data);
+};
+
+// A DiskCache key for arbitrary data: the prefix byte followed by the
+// hash_data of the data and its size.
+std::string hash_cache_key(char prefix, std::string_view data);
+
+}
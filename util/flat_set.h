@@ -0,0 +1,224 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Sets and maps stored in a sorted vector, with the interface and iteration
+// order of std::set and std::map. Lookups are binary searches and insertions
+// shift the elements after the inserted one, so these are a good fit for the
+// small containers built and merged over and over during vcgen. Unlike the
+// std containers, insertions and erasures invalidate iterators.
+
+template <typename T>
+class flat_set {
+  std::vector<T> vals;
+
+  auto find_pos(const T &v) const {
+    return std::lower_bound(vals.begin(), vals.end(), v);
+  }
+
+  bool is_at(typename std::vector<T>::const_iterator I, const T &v) const {
+    return I != vals.end() && !(v < *I);
+  }
+
+public:
+  using value_type = T;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  flat_set() = default;
+  flat_set(std::initializer_list<T> l) { insert(l.begin(), l.end()); }
+
+  std::pair<const_iterator, bool> insert(const T &v) {
+    auto I = find_pos(v);
+    if (is_at(I, v))
+      return { I, false };
+    return { vals.insert(I, v), true };
+  }
+
+  std::pair<const_iterator, bool> insert(T &&v) {
+    auto I = find_pos(v);
+    if (is_at(I, v))
+      return { I, false };
+    return { vals.insert(I, std::move(v)), true };
+  }
+
+  // Ranges of sorted distinct elements, such as those of another set, are
+  // merged in linear time.
+  template <typename It>
+  void insert(It first, It last) {
+    if (first == last)
+      return;
+    if (std::adjacent_find(first, last, [](const T &a, const T &b) {
+          return !(a < b);
+        }) != last) {
+      for (; first != last; ++first) {
+        insert(*first);
+      }
+      return;
+    }
+    if (vals.empty()) {
+      vals.assign(first, last);
+      return;
+    }
+    std::vector<T> merged;
+    merged.reserve(vals.size() + std::distance(first, last));
+    std::set_union(vals.begin(), vals.end(), first, last,
+                   std::back_inserter(merged));
+    vals = std::move(merged);
+  }
+
+  size_t erase(const T &v) {
+    auto I = find_pos(v);
+    if (!is_at(I, v))
+      return 0;
+    vals.erase(I);
+    return 1;
+  }
+
+  const_iterator find(const T &v) const {
+    auto I = find_pos(v);
+    return is_at(I, v) ? I : vals.end();
+  }
+
+  size_t count(const T &v) const { return is_at(find_pos(v), v); }
+  bool contains(const T &v) const { return count(v); }
+
+  void clear() { vals.clear(); }
+  void reserve(size_t n) { vals.reserve(n); }
+  bool empty() const { return vals.empty(); }
+  size_t size() const { return vals.size(); }
+
+  const_iterator begin() const { return vals.begin(); }
+  const_iterator end() const { return vals.end(); }
+
+  auto operator<=>(const flat_set &rhs) const { return vals <=> rhs.vals; }
+};
+
+
+template <typename K, typename V>
+class flat_map {
+  using Entry = std::pair<K, V>;
+  std::vector<Entry> vals;
+
+  template <typename Vec>
+  static auto find_pos(Vec &vals, const K &k) {
+    return std::lower_bound(vals.begin(), vals.end(), k,
+                            [](const Entry &e, const K &k) {
+                              return e.first < k;
+                            });
+  }
+
+  template <typename It>
+  bool is_at(It I, const K &k) const {
+    return I != vals.end() && !(k < I->first);
+  }
+
+  template <typename KK, typename... Args>
+  std::pair<typename std::vector<Entry>::iterator, bool>
+  do_emplace(KK &&k, Args&&... args) {
+    auto I = find_pos(vals, k);
+    if (is_at(I, k))
+      return { I, false };
+    I = vals.emplace(I, std::piecewise_construct,
+                     std::forward_as_tuple(std::forward<KK>(k)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    return { I, true };
+  }
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = Entry;
+  using iterator = typename std::vector<Entry>::iterator;
+  using const_iterator = typename std::vector<Entry>::const_iterator;
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K &k, Args&&... args) {
+    return do_emplace(k, std::forward<Args>(args)...);
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(K &&k, Args&&... args) {
+    return do_emplace(std::move(k), std::forward<Args>(args)...);
+  }
+
+  template <typename KK, typename VV>
+  std::pair<iterator, bool> emplace(KK &&k, VV &&v) {
+    return try_emplace(std::forward<KK>(k), std::forward<VV>(v));
+  }
+
+  // Keeps the existing values of duplicate keys, like std::map::insert.
+  // Ranges sorted by distinct keys, such as those of another map, are merged
+  // in linear time.
+  template <typename It>
+  void insert(It first, It last) {
+    auto less = [](const Entry &a, const Entry &b) {
+      return a.first < b.first;
+    };
+    if (first == last)
+      return;
+    if (std::adjacent_find(first, last, [&](const Entry &a, const Entry &b) {
+          return !less(a, b);
+        }) != last) {
+      for (; first != last; ++first) {
+        try_emplace(first->first, first->second);
+      }
+      return;
+    }
+    if (vals.empty()) {
+      vals.assign(first, last);
+      return;
+    }
+    std::vector<Entry> merged;
+    merged.reserve(vals.size() + std::distance(first, last));
+    std::set_union(vals.begin(), vals.end(), first, last,
+                   std::back_inserter(merged), less);
+    vals = std::move(merged);
+  }
+
+  size_t erase(const K &k) {
+    auto I = find_pos(vals, k);
+    if (!is_at(I, k))
+      return 0;
+    vals.erase(I);
+    return 1;
+  }
+
+  iterator find(const K &k) {
+    auto I = find_pos(vals, k);
+    return is_at(I, k) ? I : vals.end();
+  }
+
+  const_iterator find(const K &k) const {
+    auto I = find_pos(vals, k);
+    return is_at(I, k) ? I : vals.end();
+  }
+
+  size_t count(const K &k) const { return is_at(find_pos(vals, k), k); }
+  bool contains(const K &k) const { return count(k); }
+
+  void clear() { vals.clear(); }
+  void reserve(size_t n) { vals.reserve(n); }
+  bool empty() const { return vals.empty(); }
+  size_t size() const { return vals.size(); }
+
+  iterator begin() { return vals.begin(); }
+  iterator end() { return vals.end(); }
+  const_iterator begin() const { return vals.begin(); }
+  const_iterator end() const { return vals.end(); }
+
+  auto operator<=>(const flat_map &rhs) const { return vals <=> rhs.vals; }
+};
+
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/query_cache.h"
+#include "util/disk_cache.h"
+#include "util/random.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static bool parse_hex(string_view str, uint64_t &n) {
+  n = 0;
+  for (char c : str) {
+    unsigned digit;
+    if (c >= '0' && c <= '9')
+      digit = c - '0';
+    else if (c >= 'a' && c <= 'f')
+      digit = c - 'a' + 10;
+    else
+      return false;
+    n = (n << 4) | digit;
+  }
+  return true;
+}
+
+// Parses "<hash> <verdict>", without the newline.
+static bool parse_line(string_view line, util::QueryCache::Key &key,
+                       string_view &verdict) {
+  if (line.size() < 34 || line[32] != ' ' ||
+      !parse_hex(line.substr(0, 16), key.first) ||
+      !parse_hex(line.substr(16, 16), key.second))
+    return false;
+  verdict = line.substr(33);
+  return true;
+}
+
+namespace util {
+
+QueryCache::QueryCache(const string &dir, uint64_t max_size)
+  : path(fs::path(dir) / "verdicts"), max_size(max_size) {
+  error_code ec;
+  fs::create_directories(dir, ec);
+}
+
+QueryCache::~QueryCache() {
+  close();
+}
+
+void QueryCache::open() {
+  // Locks are shared by forked processes that inherit the descriptor, so
+  // each process opens the file itself.
+  close();
+  pid = getpid();
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  struct stat st;
+  if (fd != -1 && fstat(fd, &st) == 0)
+    ino = st.st_ino;
+}
+
+void QueryCache::close() {
+  if (fd != -1)
+    ::close(fd);
+  fd = -1;
+  ino = 0;
+  pos = 0;
+  verdicts.clear();
+}
+
+void QueryCache::refresh() {
+  // A compaction replaces the file with a new one
+  struct stat st;
+  if (pid != getpid() ||
+      (stat(path.c_str(), &st) == 0 && st.st_ino != ino))
+    open();
+  if (fd != -1)
+    readLog();
+}
+
+void QueryCache::readLog() {
+  // Other processes append to the file concurrently, so only consume
+  // complete lines.
+  char buf[1 << 16];
+  string pending;
+  while (true) {
+    auto n = pread(fd, buf, sizeof(buf), pos + pending.size());
+    if (n <= 0)
+      break;
+    pending.append(buf, n);
+  }
+
+  size_t start = 0;
+  for (size_t end; (end = pending.find('\n', start)) != string::npos;
+       start = end + 1) {
+    Key key;
+    string_view verdict;
+    if (parse_line(string_view(pending).substr(start, end - start), key,
+                   verdict))
+      verdicts[key] = verdict;
+  }
+  pos += start;
+}
+
+void QueryCache::compact() {
+  if (flock(fd, LOCK_EX) != 0)
+    return;
+
+  // another process may have compacted it already
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || st.st_ino != ino ||
+      uint64_t(st.st_size) <= max_size) {
+    flock(fd, LOCK_UN);
+    return;
+  }
+
+  vector<pair<Key, string_view>> entries;
+  unordered_map<Key, size_t, KeyHash> latest;
+  MappedFile file(path.c_str());
+  string_view lines = file ? *file : string_view();
+  for (size_t end; (end = lines.find('\n')) != string_view::npos;
+       lines.remove_prefix(end + 1)) {
+    Key key;
+    string_view verdict;
+    if (parse_line(lines.substr(0, end), key, verdict)) {
+      latest[key] = entries.size();
+      entries.emplace_back(key, verdict);
+    }
+  }
+
+  // keep the most recently written verdicts, down to 3/4 of the limit, so we
+  // don't compact on every insertion
+  vector<string> kept;
+  uint64_t size = 0;
+  for (size_t i = entries.size(); i-- > 0; ) {
+    auto &[key, verdict] = entries[i];
+    if (latest[key] != i)
+      continue;
+    auto line = to_hex(key) + ' ' + string(verdict) + '\n';
+    if (size + line.size() > max_size / 4 * 3)
+      break;
+    size += line.size();
+    kept.emplace_back(std::move(line));
+  }
+  reverse(kept.begin(), kept.end());
+
+  // Forked processes share the random state, hence the pid.
+  auto tmp = path + '.' + to_string(getpid()) + '_' + get_random_str(8);
+  int tmp_fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                      0644);
+  bool ok = tmp_fd != -1;
+  for (auto &line : kept) {
+    ok = ok && write_all(tmp_fd, line);
+  }
+  if (tmp_fd != -1)
+    ::close(tmp_fd);
+
+  error_code ec;
+  if (ok)
+    fs::rename(tmp, path, ec);
+  if (!ok || ec)
+    fs::remove(tmp, ec);
+  flock(fd, LOCK_UN);
+  open();
+}
+
+optional<string> QueryCache::get(const Key &key) {
+  lock_guard guard(mutex);
+  refresh();
+  auto I = verdicts.find(key);
+  if (I == verdicts.end())
+    return {};
+  return I->second;
+}
+
+void QueryCache::put(const Key &key, string_view verdict) {
+  lock_guard guard(mutex);
+  refresh();
+  if (fd == -1)
+    return;
+
+  // A single write with O_APPEND, so concurrent lines don't interleave
+  auto line = to_hex(key) + ' ' + string(verdict) + '\n';
+  if (!write_all(fd, line))
+    return;
+  verdicts[key] = verdict;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && uint64_t(st.st_size) > max_size)
+    compact();
+}
+
+}
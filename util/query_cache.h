@@ -0,0 +1,61 @@
+#pragma once
+
+// Copyright (c) 2018-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/disk_cache.h"
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+
+namespace util {
+
+// A cache of the verdicts of SMT queries, which can be shared by concurrent
+// processes. Verdicts are appended to the 'verdicts' file of the directory, a
+// line per query:
+//   <hash> <verdict>
+// where later lines replace earlier ones with the same hash. When the file
+// grows past max_size bytes, it is compacted to the latest verdicts of the
+// most recently written queries, down to 3/4 of the limit. Verdicts appended
+// while another process compacts the file may be lost, which only costs a
+// cache miss.
+// Failures to read or write the file are treated as cache misses.
+class QueryCache {
+public:
+  // The hash_data of the query
+  using Key = DataHash;
+
+private:
+  struct KeyHash {
+    size_t operator()(const Key &k) const { return k.first; }
+  };
+
+  std::string path;
+  uint64_t max_size;
+  pid_t pid = -1; // the process that opened the file
+  int fd = -1;
+  ino_t ino = 0;
+  size_t pos = 0; // how much of the file has been read
+  std::unordered_map<Key, std::string, KeyHash> verdicts;
+  std::mutex mutex;
+
+  void open();
+  void close();
+  void refresh();
+  void readLog();
+  void compact();
+
+public:
+  QueryCache(const std::string &dir, uint64_t max_size);
+  QueryCache(const QueryCache &) = delete;
+  ~QueryCache();
+
+  std::optional<std::string> get(const Key &key);
+  void put(const Key &key, std::string_view verdict);
+};
+
+}
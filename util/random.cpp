@@ -7,15 +7,15 @@
 
 using namespace std;
 
-static default_random_engine re;
-static mt19937 re2;
+static thread_local default_random_engine re;
+static thread_local mt19937 re2;
 static uniform_int_distribution<uint32_t> rand_int32{0};
 static uniform_int_distribution<uint64_t> rand_int64{0};
 static uniform_real_distribution<float> rand_float{0.0, numeric_limits<float>::max()};
 static uniform_real_distribution<double> rand_double{0.0, numeric_limits<double>::max()};
 
 static void seed() {
-  static bool seeded = false;
+  static thread_local bool seeded = false;
   if (!seeded) {
     random_device rd;
     re.seed(rd());
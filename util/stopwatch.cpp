@@ -3,6 +3,7 @@
 
 #include "util/stopwatch.h"
 #include <cassert>
+#include <ctime>
 #include <iomanip>
 
 using namespace std;
@@ -12,15 +13,23 @@ static auto now() {
   return steady_clock::now();
 }
 
+static nanoseconds thread_cpu_now() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec);
+}
+
 namespace util {
 
 StopWatch::StopWatch() {
   start = now();
+  cpu_start = thread_cpu_now();
 }
 
 void StopWatch::stop() {
   assert(!stopped);
   end = now();
+  cpu_end = thread_cpu_now();
   assert((stopped = true));
 }
 
@@ -29,6 +38,11 @@ float StopWatch::seconds() const {
   return duration_cast<duration<float>>(end - start).count();
 }
 
+float StopWatch::cpu_seconds() const {
+  assert(stopped);
+  return duration_cast<duration<float>>(cpu_end - cpu_start).count();
+}
+
 ostream& operator<<(ostream &os, const StopWatch &w) {
   os << fixed << setprecision(2);
   auto seconds = w.seconds();
@@ -11,6 +11,7 @@ namespace util {
 
 class StopWatch {
   std::chrono::steady_clock::time_point start, end;
+  std::chrono::nanoseconds cpu_start, cpu_end;
 #ifndef NDEBUG
   bool stopped = false;
 #endif
@@ -19,6 +20,9 @@ public:
   StopWatch();
   void stop();
   float seconds() const;
+  // CPU time used by the calling thread, so it excludes helper threads such
+  // as watchdogs. The watch must be stopped by the thread that started it.
+  float cpu_seconds() const;
 
   friend std::ostream& operator<<(std::ostream &os, const StopWatch &w);
 };
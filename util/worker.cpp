@@ -4,10 +4,12 @@
 #include "ir/type.h"
 #include "llvm_util/llvm2alive.h"
 #include "smt/smt.h"
+#include "smt/solver.h"
 #include "tools/transform.h"
 #include "util/config.h"
 #include "util/errors.h"
 #include "util/interp.h"
+#include "util/stopwatch.h"
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
@@ -22,9 +24,11 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include <jsoncons/byte_string.hpp>
@@ -41,6 +45,33 @@ using jsoncons::ojson;
 
 static optional<smt::smt_initializer> smt_init;
 
+static constexpr uint64_t default_max_steps = 1024;
+static constexpr uint64_t default_smt_timeout = 10000;
+
+namespace {
+struct PhaseTime {
+  float wall = 0, cpu = 0;
+
+  void operator+=(const StopWatch &sw) {
+    wall += sw.seconds();
+    cpu += sw.cpu_seconds();
+  }
+  ojson toJSON() const {
+    return ojson(json_object_arg, {{"wall", wall}, {"cpu", cpu}});
+  }
+};
+
+// Cost of the job being evaluated, returned in the "stats" field of the
+// result.
+struct JobStats {
+  PhaseTime parse, llvm2alive, verify;
+} job_stats;
+} // end anonymous namespace
+
+// Args of the job being evaluated that were passed without copying them into
+// the job (see evaluateAliveFunc()).
+static const vector<string_view> *job_raw_args;
+
 static llvm::Function &getSoleDefinition(llvm::Module &m) {
   for (llvm::Function &f : m.functions())
     if (!f.isDeclaration())
@@ -295,6 +326,9 @@ bool VerifyResults::addSolverError(const smt::Result &r) {
   } else if (r.isTimeout()) {
     result["status"] = "solver_timeout";
     return false;
+  } else if (r.isMemout()) {
+    result["status"] = "solver_memout";
+    return false;
   } else if (r.isError()) {
     result["status"] = "solver_error";
     add("SMT Error: " + r.getReason(), false);
@@ -330,8 +364,11 @@ static VerifyResults verify(llvm::Function &f1, llvm::Function &f2,
                             llvm::TargetLibraryInfoWrapperPass &tli,
                             const VerifyOptions &options) {
   VerifyResults r;
+  StopWatch translate_sw;
   auto fn1 = llvm2alive(f1, tli.getTLI(f1));
   auto fn2 = llvm2alive(f2, tli.getTLI(f2));
+  translate_sw.stop();
+  job_stats.llvm2alive += translate_sw;
   if (!fn1 || !fn2) {
     r.result["status"] = "could_not_translate";
     r.result["valid"] = ojson(nullptr); // unknown
@@ -367,7 +404,10 @@ static VerifyResults verify(llvm::Function &f1, llvm::Function &f2,
   }
   assert(types.hasSingleTyping());
 
+  StopWatch verify_sw;
   verifier.verify(r);
+  verify_sw.stop();
+  job_stats.verify += verify_sw;
   r.checkErrs();
   return r;
 }
@@ -617,54 +657,42 @@ shared_ptr<ConcreteVal> WorkerInterpreter::getInputValue(unsigned index,
       loadConcreteVal(input.getType(), test_input["args"][index]));
 }
 
-static ojson evaluateAliveInterpret(const ojson &options, const ojson &src,
-                                    const ojson &test_input) {
-  // TODO: is it better to use max_steps or use a timeout?
-  uint64_t max_steps =
-      options.get_with_default<uint64_t>("max_steps", uint64_t(1024));
-
-  auto to_stringref = [](const ojson &node) {
-    auto bytes = node.as_byte_string_view();
-    return llvm::StringRef(reinterpret_cast<const char *>(bytes.data()),
-                           bytes.size());
-  };
+static llvm::StringRef getArgBytes(const ojson &args, size_t i) {
+  if (args[i].is_null() && i < job_raw_args->size())
+    return (*job_raw_args)[i];
+  auto bytes = args[i].as_byte_string_view();
+  return llvm::StringRef(reinterpret_cast<const char *>(bytes.data()),
+                         bytes.size());
+}
 
-  llvm::LLVMContext context;
-  auto m_or_err = llvm::parseBitcodeFile(
-      llvm::MemoryBufferRef(to_stringref(src), "src"), context);
+static unique_ptr<llvm::Module> parseModule(const ojson &args, size_t i,
+                                            const char *name,
+                                            llvm::LLVMContext &context) {
+  llvm::StringRef buffer = getArgBytes(args, i);
+  auto m_or_err =
+      llvm::parseBitcodeFile(llvm::MemoryBufferRef(buffer, name), context);
   if (!m_or_err) {
     std::cerr << "could not parse bitcode file\n";
     _exit(1);
   }
-  auto m = std::move(*m_or_err);
-
-  auto &dl = m->getDataLayout();
-  llvm::Triple target_triple(m->getTargetTriple());
-  llvm::TargetLibraryInfoWrapperPass tli(target_triple);
-
-  std::ostringstream out;
-  llvm_util::initializer llvm_util_init(out, dl);
-  // TODO: include contents of out.str() in the response.
+  return std::move(*m_or_err);
+}
 
-  auto &f = getSoleDefinition(*m);
-  auto fn = llvm2alive(f, tli.getTLI(f));
+// Interprets fn on a single test input. fn is left unchanged, so it can be
+// reused for other inputs.
+static ojson interpretFunction(IR::Function &fn, const ojson &test_input,
+                               uint64_t max_steps) {
   ojson result(json_object_arg);
-  if (!fn) {
-    result["status"] = "unsupported";
-    result["unsupported"] = "could not translate to Alive IR";
-    return result;
-  }
-
   WorkerInterpreter interpreter(test_input);
   if (test_input.contains("memory")) {
-    IR::bits_program_pointer = fn->bitsPointers();
+    IR::bits_program_pointer = fn.bitsPointers();
     IR::bits_byte = 8; // interpreter doesn't support larger values
     // TODO: I think we need to set IR::bits_for_offset and
     // probably need to compute max_access_size to completely handle geps with
     // inbound
     interpreter.loadMemory(test_input["memory"]);
   }
-  interpreter.start(*fn, util::Interpreter::input_type::FIXED);
+  interpreter.start(fn, util::Interpreter::input_type::FIXED);
   interpreter.run(max_steps);
   if (interpreter.isUnsupported()) {
     result["status"] = "unsupported";
@@ -676,7 +704,7 @@ static ojson evaluateAliveInterpret(const ojson &options, const ojson &src,
     result["status"] = "done";
     result["undefined"] = false;
     result["return_value"] =
-        storeConcreteVal(fn->getType(), interpreter.return_value);
+        storeConcreteVal(fn.getType(), interpreter.return_value);
     if (!interpreter.mem_blocks.empty()) {
       ojson tmp(json_array_arg);
       for (const auto &block : interpreter.mem_blocks)
@@ -689,13 +717,56 @@ static ojson evaluateAliveInterpret(const ojson &options, const ojson &src,
   return result;
 }
 
-static ojson evaluateAliveTV(const ojson &options, const ojson &src,
-                             const ojson &tgt) {
+// args[1] is the module and args[2] the test input. If batch is set,
+// args[2..] are test inputs, all run on the same translated function.
+static ojson evaluateAliveInterpret(const ojson &args, bool batch) {
+  // TODO: is it better to use max_steps or use a timeout?
+  uint64_t max_steps =
+      args[0].get_with_default<uint64_t>("max_steps", default_max_steps);
+
+  llvm::LLVMContext context;
+  StopWatch parse_sw;
+  auto m = parseModule(args, 1, "src", context);
+  parse_sw.stop();
+  job_stats.parse += parse_sw;
+
+  auto &dl = m->getDataLayout();
+  llvm::Triple target_triple(m->getTargetTriple());
+  llvm::TargetLibraryInfoWrapperPass tli(target_triple);
+
+  std::ostringstream out;
+  llvm_util::initializer llvm_util_init(out, dl);
+  // TODO: include contents of out.str() in the response.
+
+  auto &f = getSoleDefinition(*m);
+  StopWatch translate_sw;
+  auto fn = llvm2alive(f, tli.getTLI(f));
+  translate_sw.stop();
+  job_stats.llvm2alive += translate_sw;
+  ojson result(json_object_arg);
+  if (!fn) {
+    result["status"] = "unsupported";
+    result["unsupported"] = "could not translate to Alive IR";
+    return result;
+  }
+
+  if (!batch)
+    return interpretFunction(*fn, args[2], max_steps);
+
+  ojson results(json_array_arg);
+  for (size_t i = 2; i < args.size(); ++i)
+    results.emplace_back(interpretFunction(*fn, args[i], max_steps));
+  result["status"] = "done";
+  result["results"] = std::move(results);
+  return result;
+}
+
+static VerifyOptions applyTVOptions(const ojson &options) {
   VerifyOptions verify_options;
   verify_options.verify_syntactic_eq =
       options.get_with_default<bool>("verify_syntactic_eq", false);
   uint64_t smt_timeout =
-      options.get_with_default<uint64_t>("smt_timeout", 10000);
+      options.get_with_default<uint64_t>("smt_timeout", default_smt_timeout);
   uint64_t smt_max_mem =
       options.get_with_default<uint64_t>("smt_max_mem", 1024);
   uint64_t smt_random_seed =
@@ -705,26 +776,22 @@ static ojson evaluateAliveTV(const ojson &options, const ojson &src,
   config::disable_undef_input =
       options.get_with_default<bool>("disable_undef_input", false);
 
-  auto to_stringref = [](const ojson &node) {
-    auto bytes = node.as_byte_string_view();
-    return llvm::StringRef(reinterpret_cast<const char *>(bytes.data()),
-                           bytes.size());
-  };
-
   smt::set_query_timeout(to_string(smt_timeout));
   smt::set_memory_limit(smt_max_mem * 1024 * 1024);
+  smt::solver_memory_governor(options.contains("smt_max_mem"));
   smt::set_random_seed(to_string(smt_random_seed));
+  return verify_options;
+}
+
+static ojson evaluateAliveTV(const ojson &args) {
+  auto verify_options = applyTVOptions(args[0]);
 
   llvm::LLVMContext context;
-  auto m1_or_err = llvm::parseBitcodeFile(
-      llvm::MemoryBufferRef(to_stringref(src), "src"), context);
-  auto m2_or_err = llvm::parseBitcodeFile(
-      llvm::MemoryBufferRef(to_stringref(tgt), "tgt"), context);
-  if (!m1_or_err || !m2_or_err) {
-    std::cerr << "could not parse bitcode files\n";
-    _exit(1);
-  }
-  auto m1 = std::move(*m1_or_err), m2 = std::move(*m2_or_err);
+  StopWatch parse_sw;
+  auto m1 = parseModule(args, 1, "src", context);
+  auto m2 = parseModule(args, 2, "tgt", context);
+  parse_sw.stop();
+  job_stats.parse += parse_sw;
 
   auto &dl = m1->getDataLayout();
   llvm::Triple target_triple(m1->getTargetTriple());
@@ -745,15 +812,149 @@ static ojson evaluateAliveTV(const ojson &options, const ojson &src,
   return result;
 }
 
-ojson util::evaluateAliveFunc(const ojson &job) {
+// args[1] is the source module. If args[2] is an array of [src, tgt] function
+// name pairs, the pairs are compared within the source module. Otherwise,
+// args[2..] are target modules, each compared against the source module.
+// Bitcode parsing and LLVM setup are shared by all pairs.
+static ojson evaluateAliveTVBatch(const ojson &args) {
+  auto verify_options = applyTVOptions(args[0]);
+  bool by_name = args.size() == 3 && args[2].is_array();
+
+  llvm::LLVMContext context;
+  StopWatch parse_sw;
+  auto src = parseModule(args, 1, "src", context);
+  vector<unique_ptr<llvm::Module>> tgts;
+  if (!by_name) {
+    for (size_t i = 2; i < args.size(); ++i)
+      tgts.emplace_back(parseModule(args, i, "tgt", context));
+  }
+  parse_sw.stop();
+  job_stats.parse += parse_sw;
+
+  auto &dl = src->getDataLayout();
+  llvm::Triple target_triple(src->getTargetTriple());
+  llvm::TargetLibraryInfoWrapperPass tli(target_triple);
+
+  std::ostringstream out;
+  llvm_util::initializer llvm_util_init(out, dl);
+
+  for (auto &tgt : tgts) {
+    if (src->getTargetTriple() != tgt->getTargetTriple()) {
+      std::cerr << "module target triples do not match";
+      abort();
+    }
+  }
+
+  ojson results(json_array_arg);
+  if (by_name) {
+    auto findDefinition = [&](const ojson &name) -> llvm::Function * {
+      auto *f = src->getFunction(name.as_string_view());
+      return f && !f->isDeclaration() ? f : nullptr;
+    };
+    for (const auto &pair : args[2].array_range()) {
+      auto *f1 = findDefinition(pair[0]);
+      auto *f2 = findDefinition(pair[1]);
+      if (!f1 || !f2) {
+        ojson missing(json_object_arg);
+        missing["status"] = "missing_function";
+        missing["valid"] = nullptr; // unknown
+        results.emplace_back(std::move(missing));
+        continue;
+      }
+      results.emplace_back(compareFunctions(*f1, *f2, tli, verify_options));
+    }
+  } else {
+    auto &f1 = getSoleDefinition(*src);
+    for (auto &tgt : tgts)
+      results.emplace_back(compareFunctions(f1, getSoleDefinition(*tgt), tli,
+                                            verify_options));
+  }
+
+  ojson result(json_object_arg);
+  result["status"] = "done";
+  result["results"] = std::move(results);
+  return result;
+}
+
+void util::initAliveWorker() {
+  if (!smt_init)
+    smt_init.emplace();
+}
+
+static ojson getJobStats() {
+  const auto &solver = smt::solver_get_stats();
+  // The verify phase consists of VC generation and solving, which run one
+  // after the other on this thread, so VC generation takes the rest of it.
+  PhaseTime vcgen;
+  vcgen.wall = max(0.0f, job_stats.verify.wall - solver.wall_seconds);
+  vcgen.cpu = max(0.0f, job_stats.verify.cpu - solver.cpu_seconds);
+
+  ojson stats(json_object_arg);
+  stats["parse"] = job_stats.parse.toJSON();
+  stats["llvm2alive"] = job_stats.llvm2alive.toJSON();
+  stats["vcgen"] = vcgen.toJSON();
+  stats["smt"] = ojson(json_object_arg, {{"wall", solver.wall_seconds},
+                                         {"cpu", solver.cpu_seconds}});
+  stats["num_queries"] = solver.num_queries;
+  ojson queries(json_array_arg);
+  for (auto [wall, cpu] : solver.query_seconds) {
+    queries.push_back(ojson(json_object_arg, {{"wall", wall}, {"cpu", cpu}}));
+  }
+  stats["smt_queries"] = std::move(queries);
+  stats["smt_peak_alloc_size"] = solver.peak_alloc_size;
+
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    stats["max_rss"] = uint64_t(usage.ru_maxrss) * 1024; // in bytes
+  return stats;
+}
+
+ojson util::evaluateAliveFunc(const ojson &job,
+                              const vector<string_view> &raw_args) {
+  job_stats = JobStats();
+  job_raw_args = &raw_args;
+  smt::solver_reset_stats();
+
   string func = job["func"].as<string>();
+  ojson result;
   if (func == "alive.tv_v2") {
-    return evaluateAliveTV(job["args"][0], job["args"][1], job["args"][2]);
+    result = evaluateAliveTV(job["args"]);
+  } else if (func == "alive.tv_batch") {
+    result = evaluateAliveTVBatch(job["args"]);
   } else if (func == "alive.interpret") {
-    return evaluateAliveInterpret(job["args"][0], job["args"][1],
-                                  job["args"][2]);
+    result = evaluateAliveInterpret(job["args"], false);
+  } else if (func == "alive.interpret_batch") {
+    result = evaluateAliveInterpret(job["args"], true);
   } else {
     cerr << "unsupported func \"" << func << "\"\n";
     exit(1);
   }
+  result["stats"] = getJobStats();
+  return result;
+}
+
+uint64_t util::takeJobBudget(const string &func, ojson &options) {
+  // Enforced by alive-worker, which never returns a result if it runs out.
+  options.erase("timeout");
+
+  bool interpret =
+      func == "alive.interpret" || func == "alive.interpret_batch";
+  const char *name = interpret ? "max_steps" : "smt_timeout";
+  uint64_t budget = options.get_with_default<uint64_t>(
+      name, interpret ? default_max_steps : default_smt_timeout);
+  options.erase(name);
+  return budget;
+}
+
+bool util::isOutOfBudget(const ojson &result) {
+  if (result.contains("results")) {
+    for (const auto &item : result["results"].array_range())
+      if (isOutOfBudget(item))
+        return true;
+  }
+  auto status = result.get_with_default<string>("status", "");
+  // A memout may also be a timeout in disguise, as the solver's memory use
+  // grows with the time it runs.
+  return status == "timeout" || status == "solver_timeout" ||
+         status == "solver_memout";
 }
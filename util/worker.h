@@ -4,7 +4,27 @@
 // Distributed under the MIT license that can be found in the LICENSE file.
 
 #include <jsoncons/json.hpp>
+#include <string_view>
+#include <vector>
 
 namespace util {
-jsoncons::ojson evaluateAliveFunc(const jsoncons::ojson &job);
+// Do the one-time setup that evaluateAliveFunc would otherwise do on the
+// first job. Processes forked afterwards start with it already done.
+void initAliveWorker();
+
+// To avoid copying large bitcode modules into the job, a byte string arg may
+// be replaced by null in job, and its bytes passed in raw_args at the same
+// index instead.
+jsoncons::ojson
+evaluateAliveFunc(const jsoncons::ojson &job,
+                  const std::vector<std::string_view> &raw_args = {});
+
+// The result of a job depends only on its func, its arguments and its options
+// (the first argument), except for the resource budget in the options. This
+// removes the budget from the options and returns it. A result for which
+// isOutOfBudget() is true, i.e., one where the interpreter or the solver ran
+// out of time or memory, may only be reused for jobs with at most the same
+// budget; other results may be reused regardless of the budget.
+uint64_t takeJobBudget(const std::string &func, jsoncons::ojson &options);
+bool isOutOfBudget(const jsoncons::ojson &result);
 }
@@ -0,0 +1,171 @@
+// Copyright (c) 2021-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "util/worker_yaml.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <iostream>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include <jsoncons/byte_string.hpp>
+
+using namespace std;
+using jsoncons::byte_string_arg;
+using jsoncons::byte_string_view;
+using jsoncons::decode_base64;
+using jsoncons::ojson;
+
+static ojson ir2bc(llvm::StringRef ir) {
+  llvm::SMDiagnostic err;
+  llvm::LLVMContext context;
+  auto mem_buffer = llvm::MemoryBuffer::getMemBufferCopy(ir);
+  auto mod = llvm::parseIR(mem_buffer->getMemBufferRef(), err, context);
+  if (!mod) {
+    err.print("alive-worker", llvm::errs());
+    exit(1);
+  }
+  llvm::SmallVector<char, 0> buffer;
+  llvm::raw_svector_ostream stream(buffer);
+  llvm::WriteBitcodeToFile(*mod, stream);
+  return byte_string_view(reinterpret_cast<const uint8_t *>(buffer.data()),
+                          buffer.size());
+}
+
+static ojson scalar2json(llvm::yaml::Node &node, llvm::StringRef scalar,
+                         bool plain) {
+  using namespace llvm::yaml;
+  string tag = node.getRawTag().str();
+  // https://yaml.org/spec/1.2.1/#id2805071
+  if (tag == "!" || (tag.empty() && !plain)) {
+    tag = "tag:yaml.org,2002:str";
+  } else if (tag == "?" || (tag.empty() && plain)) {
+    if (isNull(scalar)) {
+      tag = "tag:yaml.org,2002:null";
+    } else if (isBool(scalar)) {
+      tag = "tag:yaml.org,2002:bool";
+    } else if (isNumeric(scalar)) {
+      if (scalar.startswith("0x") ||
+          (!scalar.contains('.') && !scalar.contains('e') &&
+           !scalar.contains('E')))
+        tag = "tag:yaml.org,2002:int";
+      else
+        tag = "tag:yaml.org,2002:float";
+    } else {
+      tag = "tag:yaml.org,2002:str";
+    }
+  } else {
+    tag = node.getVerbatimTag();
+  }
+
+  if (tag == "tag:yaml.org,2002:null") {
+    return nullptr;
+  } else if (tag == "tag:yaml.org,2002:bool") {
+    bool result;
+    auto err = ScalarTraits<bool>::input(scalar, nullptr, result);
+    if (err.empty())
+      return result;
+  } else if (tag == "tag:yaml.org,2002:int") {
+    uint64_t result_unsigned;
+    auto err = ScalarTraits<uint64_t>::input(scalar, nullptr, result_unsigned);
+    if (err.empty())
+      return result_unsigned;
+    int64_t result_signed;
+    err = ScalarTraits<int64_t>::input(scalar, nullptr, result_signed);
+    if (err.empty())
+      return result_signed;
+  } else if (tag == "tag:yaml.org,2002:float") {
+    if (scalar == ".nan" || scalar == ".NaN" || scalar == ".NAN")
+      return NAN;
+    if (scalar == ".inf" || scalar == ".Inf" || scalar == ".INF")
+      return INFINITY;
+    if (scalar == "+.inf" || scalar == "+.Inf" || scalar == "+.INF")
+      return INFINITY;
+    if (scalar == "-.inf" || scalar == "-.Inf" || scalar == "-.INF")
+      return -INFINITY;
+    double result_float;
+    auto err = ScalarTraits<double>::input(scalar, nullptr, result_float);
+    if (err.empty())
+      return result_float;
+  } else if (tag == "tag:yaml.org,2002:str") {
+    return string_view(scalar);
+  } else if (tag == "tag:yaml.org,2002:binary") {
+    string str;
+    for (char c : scalar) {
+      if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' ||
+          c == '\f')
+        continue;
+      str.push_back(c);
+    }
+    vector<uint8_t> bytes;
+    auto err = decode_base64(str.begin(), str.end(), bytes);
+    if (err.ec != jsoncons::conv_errc::success) {
+      cerr << "invalid base64\n";
+      exit(1);
+    }
+    return ojson(byte_string_arg, bytes);
+  } else if (tag == "!ir") {
+    return ir2bc(scalar);
+  }
+  cerr << "unsupported scalar \"" << scalar.str() << "\" with tag \"" << tag
+       << "\"\n";
+  exit(1);
+}
+
+ojson util::yaml2json(llvm::yaml::Node &node) {
+  using namespace llvm::yaml;
+  switch (node.getType()) {
+  case Node::NK_Null:
+    return nullptr;
+  case Node::NK_Scalar: {
+    bool plain = true;
+    auto raw = static_cast<ScalarNode &>(node).getRawValue();
+    if (raw.startswith("\"") || raw.startswith("'"))
+      plain = false;
+    llvm::SmallVector<char, 32> storage;
+    auto val = static_cast<ScalarNode &>(node).getValue(storage);
+    return scalar2json(node, val, plain);
+  }
+  case Node::NK_BlockScalar:
+    return scalar2json(node, static_cast<BlockScalarNode &>(node).getValue(),
+                       false);
+  case Node::NK_Sequence: {
+    ojson::array result;
+    for (auto &item : static_cast<SequenceNode &>(node))
+      result.emplace_back(yaml2json(item));
+    return result;
+  }
+  case Node::NK_Mapping: {
+    ojson::object result;
+    for (auto &item : static_cast<MappingNode &>(node)) {
+      auto &key = *item.getKey();
+      string key_str;
+      if (key.getType() == Node::NK_Scalar) {
+        llvm::SmallVector<char, 32> storage;
+        auto key_val = static_cast<ScalarNode &>(key).getValue(storage);
+        key_str = key_val.str();
+      } else if (key.getType() == Node::NK_BlockScalar) {
+        key_str = static_cast<BlockScalarNode &>(key).getValue().str();
+      } else {
+        cerr << "unsupported type in YAML key\n";
+        exit(1);
+      }
+      result.insert_or_assign(key_str, yaml2json(*item.getValue()));
+    }
+    return result;
+  }
+  default:
+    cerr << "unsupported YAML type\n";
+    exit(1);
+  }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Copyright (c) 2021-present The Alive2 Authors.
+// Distributed under the MIT license that can be found in the LICENSE file.
+
+#include "llvm/Support/YAMLParser.h"
+
+#include <jsoncons/json.hpp>
+
+namespace util {
+// Converts a YAML document describing a worker job, as in tests/worker-*, to
+// JSON. Scalars tagged with !ir are LLVM IR, which is converted to a bitcode
+// byte string.
+jsoncons::ojson yaml2json(llvm::yaml::Node &node);
+}